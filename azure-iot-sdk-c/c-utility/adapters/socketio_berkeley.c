@@ -38,7 +38,9 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <sys/uio.h>
 #include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/constbuffer.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/gbnetwork.h"
 #include "azure_c_shared_utility/optimize_size.h"
@@ -64,6 +66,11 @@
 // connect timeout in seconds
 #define CONNECT_TIMEOUT         10
 
+// most pending buffers gathered into one sendmsg
+#ifndef SOCKETIO_SEND_IOV_COUNT
+#define SOCKETIO_SEND_IOV_COUNT 64
+#endif
+
 typedef enum IO_STATE_TAG
 {
     IO_STATE_CLOSED,
@@ -75,8 +82,10 @@ typedef enum IO_STATE_TAG
 
 typedef struct PENDING_SOCKET_IO_TAG
 {
-    unsigned char* bytes;
+    const unsigned char* bytes;
     size_t size;
+    size_t offset; // bytes already sent, a partial send advances this rather than moving the data
+    CONSTBUFFER_HANDLE constbuffer; // referenced caller buffer, NULL when bytes is a copy allocated with this entry
     ON_SEND_COMPLETE on_send_complete;
     void* callback_context;
     SINGLYLINKEDLIST_HANDLE pending_io_list;
@@ -97,8 +106,12 @@ typedef struct SOCKET_IO_INSTANCE_TAG
     char* target_mac_address;
     IO_STATE io_state;
     SINGLYLINKEDLIST_HANDLE pending_io_list;
-    unsigned char recv_bytes[XIO_RECEIVE_BUFFER_SIZE];
+    unsigned char* recv_bytes;
+    size_t recv_buffer_size;
     DNSRESOLVER_HANDLE dns_resolver;
+    SOCKETIO_WATCH socket_watch;
+    int watched_socket;
+    int watched_send_pending;
 } SOCKET_IO_INSTANCE;
 
 typedef struct NETWORK_INTERFACE_DESCRIPTION_TAG
@@ -136,6 +149,36 @@ static void* socketio_CloneOption(const char* name, const void* value)
                 }
             }
         }
+        else if (strcmp(name, OPTION_SOCKET_WATCH) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(SOCKETIO_WATCH))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                (void)memcpy(result, value, sizeof(SOCKETIO_WATCH));
+            }
+        }
+        else if (strcmp(name, OPTION_SOCKET_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                *(size_t*)result = *(const size_t*)value;
+            }
+        }
         else
         {
             LogError("Cannot clone option %s (not suppported)", name);
@@ -153,7 +196,7 @@ static void socketio_DestroyOption(const char* name, const void* value)
 {
     if (name != NULL)
     {
-        if (strcmp(name, OPTION_NET_INT_MAC_ADDRESS) == 0 && value != NULL)
+        if ((strcmp(name, OPTION_NET_INT_MAC_ADDRESS) == 0 || strcmp(name, OPTION_SOCKET_WATCH) == 0 || strcmp(name, OPTION_SOCKET_RECEIVE_BUFFER_SIZE) == 0) && value != NULL)
         {
             free((void*)value);
         }
@@ -185,6 +228,20 @@ static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE handle)
             OptionHandler_Destroy(result);
             result = NULL;
         }
+        else if (socket_io_instance->socket_watch.on_watch_changed != NULL &&
+            OptionHandler_AddOption(result, OPTION_SOCKET_WATCH, &socket_io_instance->socket_watch) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding socket_watch)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (socket_io_instance->recv_buffer_size != SOCKETIO_RECEIVE_BUFFER_SIZE &&
+            OptionHandler_AddOption(result, OPTION_SOCKET_RECEIVE_BUFFER_SIZE, &socket_io_instance->recv_buffer_size) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding socket_receive_buffer_size)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
     }
 
     return result;
@@ -199,57 +256,224 @@ static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
     socketio_close,
     socketio_send,
     socketio_dowork,
-    socketio_setoption
+    socketio_setoption,
+    socketio_send_vectored
 };
 
+/* Tells the socket watcher (if any) which socket to poll. Only an open socket is watched, and the watcher
+   is only called when the socket or the pending send state actually changes. */
+static void update_socket_watch(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if (socket_io_instance->socket_watch.on_watch_changed != NULL)
+    {
+        int socket = (socket_io_instance->io_state == IO_STATE_OPEN) ? socket_io_instance->socket : INVALID_SOCKET;
+        int send_pending = (socket != INVALID_SOCKET) && (singlylinkedlist_get_head_item(socket_io_instance->pending_io_list) != NULL);
+
+        if (socket != socket_io_instance->watched_socket || send_pending != socket_io_instance->watched_send_pending)
+        {
+            socket_io_instance->watched_socket = socket;
+            socket_io_instance->watched_send_pending = send_pending;
+            socket_io_instance->socket_watch.on_watch_changed(socket_io_instance->socket_watch.context, socket, send_pending);
+        }
+    }
+}
+
+/* Must be called before the socket is closed, a watcher may not poll a closed descriptor */
+static void clear_socket_watch(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if (socket_io_instance->socket_watch.on_watch_changed != NULL && socket_io_instance->watched_socket != INVALID_SOCKET)
+    {
+        socket_io_instance->watched_socket = INVALID_SOCKET;
+        socket_io_instance->watched_send_pending = 0;
+        socket_io_instance->socket_watch.on_watch_changed(socket_io_instance->socket_watch.context, INVALID_SOCKET, 0);
+    }
+}
+
 static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
 {
     socket_io_instance->io_state = IO_STATE_ERROR;
+    clear_socket_watch(socket_io_instance);
     if (socket_io_instance->on_io_error != NULL)
     {
         socket_io_instance->on_io_error(socket_io_instance->on_io_error_context);
     }
 }
 
-static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned char* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+/* Queues the bytes of buffers that follow the first skip bytes as one entry. A constbuffer (the only buffer) is
+   referenced rather than copied, otherwise the bytes are gathered into the same allocation as the entry. */
+static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const XIO_SEND_BUFFER* buffers, size_t buffer_count, size_t skip, CONSTBUFFER_HANDLE constbuffer, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     int result;
-    PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)malloc(sizeof(PENDING_SOCKET_IO));
+    size_t size = 0;
+    size_t i;
+    PENDING_SOCKET_IO* pending_socket_io;
+
+    for (i = 0; i < buffer_count; i++)
+    {
+        size += buffers[i].size;
+    }
+    size -= skip;
+
+    pending_socket_io = (PENDING_SOCKET_IO*)malloc(sizeof(PENDING_SOCKET_IO) + (constbuffer == NULL ? size : 0));
     if (pending_socket_io == NULL)
     {
+        LogError("Allocation Failure: Unable to allocate pending list.");
         result = MU_FAILURE;
     }
     else
     {
-        pending_socket_io->bytes = (unsigned char*)malloc(size);
-        if (pending_socket_io->bytes == NULL)
+        if (constbuffer == NULL)
+        {
+            unsigned char* bytes = (unsigned char*)(pending_socket_io + 1);
+            for (i = 0; i < buffer_count; i++)
+            {
+                if (skip >= buffers[i].size)
+                {
+                    skip -= buffers[i].size;
+                }
+                else
+                {
+                    (void)memcpy(bytes, (const unsigned char*)buffers[i].buffer + skip, buffers[i].size - skip);
+                    bytes += buffers[i].size - skip;
+                    skip = 0;
+                }
+            }
+            pending_socket_io->bytes = (const unsigned char*)(pending_socket_io + 1);
+        }
+        else
+        {
+            CONSTBUFFER_IncRef(constbuffer);
+            pending_socket_io->bytes = (const unsigned char*)buffers[0].buffer + skip;
+        }
+
+        pending_socket_io->size = size;
+        pending_socket_io->offset = 0;
+        pending_socket_io->constbuffer = constbuffer;
+        pending_socket_io->on_send_complete = on_send_complete;
+        pending_socket_io->callback_context = callback_context;
+        pending_socket_io->pending_io_list = socket_io_instance->pending_io_list;
+
+        if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
         {
-            LogError("Allocation Failure: Unable to allocate pending list.");
+            LogError("Failure: Unable to add socket to pending list.");
+            if (constbuffer != NULL)
+            {
+                CONSTBUFFER_DecRef(constbuffer);
+            }
             free(pending_socket_io);
             result = MU_FAILURE;
         }
         else
         {
-            pending_socket_io->size = size;
-            pending_socket_io->on_send_complete = on_send_complete;
-            pending_socket_io->callback_context = callback_context;
-            pending_socket_io->pending_io_list = socket_io_instance->pending_io_list;
-            (void)memcpy(pending_socket_io->bytes, buffer, size);
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static void free_pending_io(PENDING_SOCKET_IO* pending_socket_io)
+{
+    if (pending_socket_io->constbuffer != NULL)
+    {
+        CONSTBUFFER_DecRef(pending_socket_io->constbuffer);
+    }
+    free(pending_socket_io);
+}
+
+/* Sends the pending chain, up to SOCKETIO_SEND_IOV_COUNT buffers per sendmsg, until it is empty or the socket stops
+   accepting data. Completed buffers are completed in order, a partially sent buffer keeps its offset. */
+static void send_pending_io(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    LIST_ITEM_HANDLE pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
 
-            if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
+    while (pending_io != NULL && socket_io_instance->io_state == IO_STATE_OPEN)
+    {
+        struct iovec iov[SOCKETIO_SEND_IOV_COUNT];
+        struct msghdr msg;
+        size_t iov_count = 0;
+        size_t queued = 0;
+        ssize_t send_result;
+
+        for (; pending_io != NULL && iov_count < SOCKETIO_SEND_IOV_COUNT; pending_io = singlylinkedlist_get_next_item(pending_io))
+        {
+            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(pending_io);
+            if (pending_socket_io == NULL)
             {
-                LogError("Failure: Unable to add socket to pending list.");
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-                result = MU_FAILURE;
+                break;
             }
-            else
+            iov[iov_count].iov_base = (void*)(pending_socket_io->bytes + pending_socket_io->offset);
+            iov[iov_count].iov_len = pending_socket_io->size - pending_socket_io->offset;
+            queued += iov[iov_count].iov_len;
+            iov_count++;
+        }
+
+        if (iov_count == 0)
+        {
+            indicate_error(socket_io_instance);
+            LogError("Failure: retrieving socket from list");
+            break;
+        }
+
+        (void)memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_count;
+
+        send_result = sendmsg(socket_io_instance->socket, &msg, MSG_NOSIGNAL);
+        if (send_result < 0)
+        {
+            if (errno != EAGAIN && errno != ENOBUFS)
             {
-                result = 0;
+                LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+
+                free_pending_io((PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io));
+                (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
+
+                LogError("Failure: sending Socket information. errno=%d (%s).", errno, strerror(errno));
+                indicate_error(socket_io_instance);
             }
+            /*send says "come back later" with EAGAIN, ENOBUFS - likely the socket buffer cannot accept more data*/
+            break;
         }
+        else
+        {
+            size_t sent = (size_t)send_result;
+
+            while (sent > 0)
+            {
+                LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+                PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
+                size_t remaining = pending_socket_io->size - pending_socket_io->offset;
+
+                if (sent < remaining)
+                {
+                    /* simply wait until next dowork */
+                    pending_socket_io->offset += sent;
+                    break;
+                }
+
+                sent -= remaining;
+                if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
+                {
+                    indicate_error(socket_io_instance);
+                    LogError("Failure: unable to remove socket from list");
+                    break;
+                }
+
+                if (pending_socket_io->on_send_complete != NULL)
+                {
+                    pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
+                }
+                free_pending_io(pending_socket_io);
+            }
+
+            if ((size_t)send_result < queued)
+            {
+                break;
+            }
+        }
+
+        pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
     }
-    return result;
 }
 
 static STATIC_VAR_UNUSED void signal_callback(int signum)
@@ -704,6 +928,7 @@ static void destroy_socket_io_instance(SOCKET_IO_INSTANCE* instance)
 
     free(instance->hostname);
     free(instance->target_mac_address);
+    free(instance->recv_bytes);
 
     if (instance->pending_io_list != NULL)
     {
@@ -731,6 +956,7 @@ CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
             (void)memset(result, 0, sizeof(SOCKET_IO_INSTANCE));
 
             result->address_type = ADDRESS_TYPE_IP;
+            result->recv_buffer_size = SOCKETIO_RECEIVE_BUFFER_SIZE;
             result->pending_io_list = singlylinkedlist_create();
             if (result->pending_io_list == NULL)
             {
@@ -773,6 +999,7 @@ CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
                     result->on_bytes_received_context = NULL;
                     result->on_io_error_context = NULL;
                     result->io_state = IO_STATE_CLOSED;
+                    result->watched_socket = INVALID_SOCKET;
                 }
             }
         }
@@ -790,6 +1017,8 @@ void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
     if (socket_io != NULL)
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        clear_socket_watch(socket_io_instance);
+
         /* we cannot do much if the close fails, so just ignore the result */
         if (socket_io_instance->socket != INVALID_SOCKET)
         {
@@ -803,8 +1032,7 @@ void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
             PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
             if (pending_socket_io != NULL)
             {
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
+                free_pending_io(pending_socket_io);
             }
 
             (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
@@ -876,6 +1104,11 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
         }
     }
 
+    if (result == 0)
+    {
+        update_socket_watch(socket_io_instance);
+    }
+
     return result;
 }
 
@@ -893,6 +1126,7 @@ int socketio_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_clos
         if ((socket_io_instance->io_state != IO_STATE_CLOSED) && (socket_io_instance->io_state != IO_STATE_CLOSING))
         {
             // Only close if the socket isn't already in the closed or closing state
+            clear_socket_watch(socket_io_instance);
             (void)shutdown(socket_io_instance->socket, SHUT_RDWR);
             close(socket_io_instance->socket);
             socket_io_instance->socket = INVALID_SOCKET;
@@ -910,12 +1144,24 @@ int socketio_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_clos
     return result;
 }
 
-int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+static int send_or_queue(CONCRETE_IO_HANDLE socket_io, const XIO_SEND_BUFFER* buffers, size_t buffer_count, CONSTBUFFER_HANDLE constbuffer, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     int result;
+    size_t size = 0;
+    size_t i;
+
+    for (i = 0; buffers != NULL && i < buffer_count; i++)
+    {
+        if (buffers[i].buffer == NULL && buffers[i].size > 0)
+        {
+            break;
+        }
+        size += buffers[i].size;
+    }
 
     if ((socket_io == NULL) ||
-        (buffer == NULL) ||
+        (buffers == NULL) ||
+        (i < buffer_count) ||
         (size == 0))
     {
         /* Invalid arguments */
@@ -933,9 +1179,10 @@ int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size,
         else
         {
             LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-            if (first_pending_io != NULL)
+            if (first_pending_io != NULL || buffer_count > SOCKETIO_SEND_IOV_COUNT)
             {
-                if (add_pending_io(socket_io_instance, buffer, size, on_send_complete, callback_context) != 0)
+                /* sent with the rest of the chain on the next dowork */
+                if (add_pending_io(socket_io_instance, buffers, buffer_count, 0, constbuffer, on_send_complete, callback_context) != 0)
                 {
                     LogError("Failure: add_pending_io failed.");
                     result = MU_FAILURE;
@@ -947,9 +1194,21 @@ int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size,
             }
             else
             {
+                struct iovec iov[SOCKETIO_SEND_IOV_COUNT];
+                struct msghdr msg;
+
+                for (i = 0; i < buffer_count; i++)
+                {
+                    iov[i].iov_base = (void*)buffers[i].buffer;
+                    iov[i].iov_len = buffers[i].size;
+                }
+                (void)memset(&msg, 0, sizeof(msg));
+                msg.msg_iov = iov;
+                msg.msg_iovlen = buffer_count;
+
                 signal(SIGPIPE, SIG_IGN);
 
-                ssize_t send_result = send(socket_io_instance->socket, buffer, size, MSG_NOSIGNAL);
+                ssize_t send_result = sendmsg(socket_io_instance->socket, &msg, MSG_NOSIGNAL);
                 if ((size_t)send_result != size)
                 {
                     if (send_result == SOCKET_SEND_FAILURE && errno != EAGAIN && errno != ENOBUFS)
@@ -963,7 +1222,7 @@ int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size,
                         /* queue data */
                         size_t bytes_sent = (send_result < 0 ? 0 : send_result);
 
-                        if (add_pending_io(socket_io_instance, (const unsigned char*)buffer + bytes_sent, size - bytes_sent, on_send_complete, callback_context) != 0)
+                        if (add_pending_io(socket_io_instance, buffers, buffer_count, bytes_sent, constbuffer, on_send_complete, callback_context) != 0)
                         {
                             LogError("Failure: add_pending_io failed.");
                             result = MU_FAILURE;
@@ -984,12 +1243,50 @@ int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size,
                     result = 0;
                 }
             }
+
+            update_socket_watch(socket_io_instance);
         }
     }
 
     return result;
 }
 
+int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    XIO_SEND_BUFFER send_buffer;
+    send_buffer.buffer = buffer;
+    send_buffer.size = size;
+
+    return send_or_queue(socket_io, &send_buffer, 1, NULL, on_send_complete, callback_context);
+}
+
+int socketio_send_vectored(CONCRETE_IO_HANDLE socket_io, const XIO_SEND_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    return send_or_queue(socket_io, buffers, buffer_count, NULL, on_send_complete, callback_context);
+}
+
+int socketio_send_constbuffer(CONCRETE_IO_HANDLE socket_io, CONSTBUFFER_HANDLE buffer, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if (buffer == NULL)
+    {
+        LogError("Invalid argument: send given invalid parameter");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        const CONSTBUFFER* content = CONSTBUFFER_GetContent(buffer);
+        XIO_SEND_BUFFER send_buffer;
+        send_buffer.buffer = content->buffer;
+        send_buffer.size = content->size;
+
+        result = send_or_queue(socket_io, &send_buffer, 1, buffer, on_send_complete, callback_context);
+    }
+
+    return result;
+}
+
 void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
 {
     if (socket_io != NULL)
@@ -999,70 +1296,23 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
 
         if (socket_io_instance->io_state == IO_STATE_OPEN)
         {
-            LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-            while (first_pending_io != NULL)
+            send_pending_io(socket_io_instance);
+
+            if (socket_io_instance->io_state == IO_STATE_OPEN && socket_io_instance->recv_bytes == NULL)
             {
-                PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-                if (pending_socket_io == NULL)
+                if ((socket_io_instance->recv_bytes = (unsigned char*)malloc(socket_io_instance->recv_buffer_size)) == NULL)
                 {
+                    LogError("Socketio_Failure: Unable to allocate %lu byte receive buffer.", (unsigned long)socket_io_instance->recv_buffer_size);
                     indicate_error(socket_io_instance);
-                    LogError("Failure: retrieving socket from list");
-                    break;
-                }
-
-                ssize_t send_result = send(socket_io_instance->socket, pending_socket_io->bytes, pending_socket_io->size, MSG_NOSIGNAL);
-                if ((send_result < 0) || ((size_t)send_result != pending_socket_io->size))
-                {
-                    if (send_result == INVALID_SOCKET)
-                    {
-                        if (errno == EAGAIN  || errno == ENOBUFS) /*send says "come back later" with EAGAIN, ENOBUFS - likely the socket buffer cannot accept more data*/
-                        {
-                            /*do nothing until next dowork */
-                            break;
-                        }
-                        else
-                        {
-                            free(pending_socket_io->bytes);
-                            free(pending_socket_io);
-                            (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
-
-                            LogError("Failure: sending Socket information. errno=%d (%s).", errno, strerror(errno));
-                            indicate_error(socket_io_instance);
-                        }
-                    }
-                    else
-                    {
-                        /* simply wait until next dowork */
-                        (void)memmove(pending_socket_io->bytes, pending_socket_io->bytes + send_result, pending_socket_io->size - send_result);
-                        pending_socket_io->size -= send_result;
-                        break;
-                    }
-                }
-                else
-                {
-                    if (pending_socket_io->on_send_complete != NULL)
-                    {
-                        pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
-                    }
-
-                    free(pending_socket_io->bytes);
-                    free(pending_socket_io);
-                    if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
-                    {
-                        indicate_error(socket_io_instance);
-                        LogError("Failure: unable to remove socket from list");
-                    }
                 }
-
-                first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
             }
 
-             if (socket_io_instance->io_state == IO_STATE_OPEN)
+            if (socket_io_instance->io_state == IO_STATE_OPEN)
             {
                 ssize_t received = 0;
                 do
                 {
-                    received = recv(socket_io_instance->socket, socket_io_instance->recv_bytes, XIO_RECEIVE_BUFFER_SIZE, MSG_NOSIGNAL);
+                    received = recv(socket_io_instance->socket, socket_io_instance->recv_bytes, socket_io_instance->recv_buffer_size, MSG_NOSIGNAL);
                     if (received > 0)
                     {
                         if (socket_io_instance->on_bytes_received != NULL)
@@ -1070,6 +1320,13 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
                             /* Explicitly ignoring here the result of the callback */
                             (void)socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, socket_io_instance->recv_bytes, received);
                         }
+
+                        /* A short read means the socket has been drained. When a watcher polls the socket it calls dowork
+                           again as soon as more data arrives, so skip the recv that would only return EAGAIN. */
+                        if ((size_t)received < socket_io_instance->recv_buffer_size && socket_io_instance->watched_socket != INVALID_SOCKET)
+                        {
+                            break;
+                        }
                     }
                     else if (received == 0)
                     {
@@ -1113,6 +1370,8 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
 
             }
         }
+
+        update_socket_watch(socket_io_instance);
     }
 }
 
@@ -1227,6 +1486,29 @@ int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, con
         {
             result = socketio_setaddresstype_option(socket_io_instance, (const char*)value);
         }
+        else if (strcmp(optionName, OPTION_SOCKET_WATCH) == 0)
+        {
+            clear_socket_watch(socket_io_instance);
+            socket_io_instance->socket_watch = *(const SOCKETIO_WATCH*)value;
+            update_socket_watch(socket_io_instance);
+            result = 0;
+        }
+        else if (strcmp(optionName, OPTION_SOCKET_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            if (*(const size_t*)value == 0)
+            {
+                LogError("option value must be greater than 0");
+                result = MU_FAILURE;
+            }
+            else
+            {
+                /* reallocated at the new size on the next dowork */
+                free(socket_io_instance->recv_bytes);
+                socket_io_instance->recv_bytes = NULL;
+                socket_io_instance->recv_buffer_size = *(const size_t*)value;
+                result = 0;
+            }
+        }
         else
         {
             result = MU_FAILURE;
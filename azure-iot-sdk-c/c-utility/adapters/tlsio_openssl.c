@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <limits.h>
 #include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/tlsio_openssl.h"
@@ -80,6 +81,9 @@ typedef struct TLS_IO_INSTANCE_TAG
     bool ignore_host_name_check;
     ENGINE* engine;
     OPTION_OPENSSL_KEY_TYPE x509_private_key_type;
+    unsigned char* receive_buffer;
+    size_t receive_buffer_size;
+    unsigned char* send_record;
 } TLS_IO_INSTANCE;
 
 struct CRYPTO_dynlock_value
@@ -89,6 +93,8 @@ struct CRYPTO_dynlock_value
 
 static const char* const OPTION_UNDERLYING_IO_OPTIONS = "underlying_io_options";
 #define SSL_DO_HANDSHAKE_SUCCESS 1
+// largest plaintext carried by one TLS record, small vectored send buffers are coalesced up to this size
+#define TLSIO_SEND_RECORD_SIZE 16384
 
 
 /*this function will clone an option given by name and value*/
@@ -257,6 +263,21 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
 
             result = value_clone;
         }
+        else if (strcmp(name, OPTION_TLS_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            size_t* value_clone;
+
+            if ((value_clone = (size_t*)malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed cloning tls_receive_buffer_size option");
+            }
+            else
+            {
+                *value_clone = *(const size_t*)value;
+            }
+
+            result = value_clone;
+        }
         else
         {
             LogError("not handled option : %s", name);
@@ -287,7 +308,8 @@ static void tlsio_openssl_DestroyOption(const char* name, const void* value)
             (strcmp(name, OPTION_X509_ECC_KEY) == 0) ||
             (strcmp(name, OPTION_TLS_VERSION) == 0) || 
             (strcmp(name, OPTION_OPENSSL_ENGINE) == 0) || 
-            (strcmp(name, OPTION_OPENSSL_PRIVATE_KEY_TYPE) == 0)
+            (strcmp(name, OPTION_OPENSSL_PRIVATE_KEY_TYPE) == 0) ||
+            (strcmp(name, OPTION_TLS_RECEIVE_BUFFER_SIZE) == 0)
            )
         {
             free((void*)value);
@@ -400,6 +422,15 @@ static OPTIONHANDLER_HANDLE tlsio_openssl_retrieveoptions(CONCRETE_IO_HANDLE han
                     OptionHandler_Destroy(result);
                     result = NULL;
                 }
+                else if (
+                    (tls_io_instance->receive_buffer_size != TLSIO_RECEIVE_BUFFER_SIZE) &&
+                    (OptionHandler_AddOption(result, OPTION_TLS_RECEIVE_BUFFER_SIZE, &tls_io_instance->receive_buffer_size) != OPTIONHANDLER_OK)
+                    )
+                {
+                    LogError("unable to save tls_receive_buffer_size option");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
                 else if (tls_io_instance->tls_validation_callback != NULL)
                 {
 #ifdef WIN32
@@ -447,7 +478,8 @@ static const IO_INTERFACE_DESCRIPTION tlsio_openssl_interface_description =
     tlsio_openssl_close,
     tlsio_openssl_send,
     tlsio_openssl_dowork,
-    tlsio_openssl_setoption
+    tlsio_openssl_setoption,
+    tlsio_openssl_send_vectored
 };
 
 static LOCK_HANDLE * openssl_locks = NULL;
@@ -883,21 +915,43 @@ static void on_underlying_io_error(void* context)
 static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
 {
     int result = 0;
-    unsigned char buffer[64];
-
     int rcv_bytes = 1;
 
-    while (rcv_bytes > 0)
+    // decrypt into one reusable buffer sized for a whole TLS record so each record is passed up in a single call,
+    // instead of one on_bytes_received per few bytes
+    if (tls_io_instance->receive_buffer == NULL)
     {
-        if (tls_io_instance->ssl == NULL)
+        tls_io_instance->receive_buffer = malloc(tls_io_instance->receive_buffer_size);
+        if (tls_io_instance->receive_buffer == NULL)
         {
-            LogError("SSL channel closed in decode_ssl_received_bytes.");
+            LogError("Failed allocating %lu byte TLS receive buffer.", (unsigned long)tls_io_instance->receive_buffer_size);
             result = MU_FAILURE;
             return result;
         }
+    }
+
+    while (rcv_bytes > 0)
+    {
+        size_t received = 0;
 
-        rcv_bytes = SSL_read(tls_io_instance->ssl, buffer, sizeof(buffer));
-        if (rcv_bytes > 0)
+        // fill the buffer with as many decrypted records as are available before passing it up
+        do
+        {
+            if (tls_io_instance->ssl == NULL)
+            {
+                LogError("SSL channel closed in decode_ssl_received_bytes.");
+                result = MU_FAILURE;
+                return result;
+            }
+
+            rcv_bytes = SSL_read(tls_io_instance->ssl, tls_io_instance->receive_buffer + received, (int)(tls_io_instance->receive_buffer_size - received));
+            if (rcv_bytes > 0)
+            {
+                received += (size_t)rcv_bytes;
+            }
+        } while (rcv_bytes > 0 && received < tls_io_instance->receive_buffer_size);
+
+        if (received > 0)
         {
             if (tls_io_instance->on_bytes_received == NULL)
             {
@@ -905,7 +959,7 @@ static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
             }
             else
             {
-                tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, buffer, rcv_bytes);
+                tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, tls_io_instance->receive_buffer, received);
             }
         }
     }
@@ -1346,6 +1400,9 @@ CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters)
                 result->engine_id = NULL;
                 result->engine = NULL;
                 result->x509_private_key_type = KEY_TYPE_DEFAULT;
+                result->receive_buffer = NULL;
+                result->receive_buffer_size = TLSIO_RECEIVE_BUFFER_SIZE;
+                result->send_record = NULL;
 
                 result->tls_version = VERSION_1_2;
 
@@ -1403,6 +1460,8 @@ void tlsio_openssl_destroy(CONCRETE_IO_HANDLE tls_io)
             free(tls_io_instance->engine_id);
             tls_io_instance->engine_id = NULL;
         }
+        free(tls_io_instance->receive_buffer);
+        free(tls_io_instance->send_record);
 
         free(tls_io);
     }
@@ -1578,6 +1637,123 @@ int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t siz
     return result;
 }
 
+static int ssl_write_bytes(TLS_IO_INSTANCE* tls_io_instance, const unsigned char* bytes, size_t size)
+{
+    int result;
+
+    if (SSL_write(tls_io_instance->ssl, bytes, (int)size) != (int)size)
+    {
+        log_ERR_get_error("SSL_write error.");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/* Encrypts the buffers in order and hands the records to the underlying io with one xio_send. Buffers are coalesced
+   into full size records so a small header is not sent as a record of its own, once a record has been filled the
+   rest of a large buffer is encrypted in place. A failure after the first record was encrypted breaks the connection,
+   those records carry part of the message and have used up TLS sequence numbers, so they can neither be sent on their
+   own nor dropped. */
+int tlsio_openssl_send_vectored(CONCRETE_IO_HANDLE tls_io, const XIO_SEND_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if (tls_io == NULL || buffers == NULL)
+    {
+        LogError("NULL tls_io or buffers.");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        if (tls_io_instance->tlsio_state != TLSIO_STATE_OPEN)
+        {
+            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPEN.");
+            result = MU_FAILURE;
+        }
+        else if (tls_io_instance->ssl == NULL)
+        {
+            LogError("SSL channel closed in tlsio_openssl_send_vectored.");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            size_t staged = 0;
+            bool records_written = false;
+            size_t i;
+
+            result = 0;
+            for (i = 0; i < buffer_count && result == 0; i++)
+            {
+                const unsigned char* bytes = (const unsigned char*)buffers[i].buffer;
+                size_t size = buffers[i].size;
+
+                while (size > 0 && result == 0)
+                {
+                    if (staged == 0 && size >= TLSIO_SEND_RECORD_SIZE)
+                    {
+                        result = ssl_write_bytes(tls_io_instance, bytes, size);
+                        records_written = records_written || (result == 0);
+                        size = 0;
+                    }
+                    else if (tls_io_instance->send_record == NULL &&
+                        (tls_io_instance->send_record = malloc(TLSIO_SEND_RECORD_SIZE)) == NULL)
+                    {
+                        LogError("Failed allocating TLS send record.");
+                        result = MU_FAILURE;
+                    }
+                    else
+                    {
+                        size_t copy = TLSIO_SEND_RECORD_SIZE - staged;
+                        if (copy > size)
+                        {
+                            copy = size;
+                        }
+
+                        (void)memcpy(tls_io_instance->send_record + staged, bytes, copy);
+                        staged += copy;
+                        bytes += copy;
+                        size -= copy;
+
+                        if (staged == TLSIO_SEND_RECORD_SIZE)
+                        {
+                            result = ssl_write_bytes(tls_io_instance, tls_io_instance->send_record, staged);
+                            records_written = records_written || (result == 0);
+                            staged = 0;
+                        }
+                    }
+                }
+            }
+
+            if (result == 0 && staged > 0)
+            {
+                result = ssl_write_bytes(tls_io_instance, tls_io_instance->send_record, staged);
+            }
+
+            if (result != 0 && records_written)
+            {
+                (void)BIO_reset(tls_io_instance->out_bio);
+                tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+                indicate_error(tls_io_instance);
+                LogError("Failed encrypting the rest of the message, discarding the records already encrypted.");
+            }
+            else if (result == 0 && write_outgoing_bytes(tls_io_instance, on_send_complete, callback_context) != 0)
+            {
+                LogError("Error in write_outgoing_bytes.");
+                result = MU_FAILURE;
+            }
+        }
+    }
+
+    return result;
+}
+
 void tlsio_openssl_dowork(CONCRETE_IO_HANDLE tls_io)
 {
     if (tls_io == NULL)
@@ -1841,6 +2017,23 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
             // No need to do anything for Openssl
             result = 0;
         }
+        else if (strcmp(optionName, OPTION_TLS_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            const size_t receive_buffer_size = *(const size_t*)value;
+            if (receive_buffer_size == 0 || receive_buffer_size > INT_MAX)
+            {
+                LogError("Invalid tls_receive_buffer_size %lu", (unsigned long)receive_buffer_size);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                // reallocated at the new size on the next receive
+                free(tls_io_instance->receive_buffer);
+                tls_io_instance->receive_buffer = NULL;
+                tls_io_instance->receive_buffer_size = receive_buffer_size;
+                result = 0;
+            }
+        }
         else if (strcmp("ignore_host_name_check", optionName) == 0)
         {
             bool* server_name_check = (bool*)value;
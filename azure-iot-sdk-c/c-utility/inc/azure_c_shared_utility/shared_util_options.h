@@ -58,10 +58,19 @@ extern "C"
     // that in general  should not be overridden with OPTION_TLS_VERSION.
     static STATIC_VAR_UNUSED const char* const OPTION_TLS_VERSION = "tls_version";
 
+    // Value is a size_t. Size of the buffer TLS records are decrypted into before being passed up, defaults to one TLS record.
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_RECEIVE_BUFFER_SIZE = "tls_receive_buffer_size";
+
     static STATIC_VAR_UNUSED const char* const OPTION_ADDRESS_TYPE = "ADDRESS_TYPE";
     static STATIC_VAR_UNUSED const char* const OPTION_ADDRESS_TYPE_DOMAIN_SOCKET = "DOMAIN_SOCKET";
     static STATIC_VAR_UNUSED const char* const OPTION_ADDRESS_TYPE_IP_SOCKET = "IP_SOCKET";
 
+    // Value is a SOCKETIO_WATCH (see socketio.h). Lets an external event loop poll the socket instead of calling dowork on a timer.
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKET_WATCH = "socket_watch";
+
+    // Value is a size_t. Size of the buffer each recv reads into and is passed up from, defaults to SOCKETIO_RECEIVE_BUFFER_SIZE.
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKET_RECEIVE_BUFFER_SIZE = "socket_receive_buffer_size";
+
 #ifdef __cplusplus
 }
 #endif
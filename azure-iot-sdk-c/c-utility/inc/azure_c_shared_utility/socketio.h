@@ -11,6 +11,7 @@
 #endif /* __cplusplus */
 
 #include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/constbuffer.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "umock_c/umock_c_prod.h"
 
@@ -31,15 +32,37 @@ typedef enum SOCKETIO_ADDRESS_TYPE_TAG
     ADDRESS_TYPE_DOMAIN_SOCKET
 } SOCKETIO_ADDRESS_TYPE;
 
+/* Called when the socket an external event loop should watch changes. socket is -1 when there is nothing to watch
+   (not connected, closing or in error). send_pending is non-zero while queued bytes are waiting for the socket to become writable.
+   The watch must be level triggered, dowork stops reading once the socket is drained rather than reading until EAGAIN. */
+typedef void(*ON_SOCKETIO_WATCH_CHANGED)(void* context, int socket, int send_pending);
+
+typedef struct SOCKETIO_WATCH_TAG
+{
+    ON_SOCKETIO_WATCH_CHANGED on_watch_changed;
+    void* context;
+} SOCKETIO_WATCH;
+
 #ifndef XIO_RECEIVE_BUFFER_SIZE
 #define XIO_RECEIVE_BUFFER_SIZE     64
 #endif
 
+/* Default size of the socketio_berkeley receive buffer, see OPTION_SOCKET_RECEIVE_BUFFER_SIZE. It is allocated on the heap
+   so, unlike XIO_RECEIVE_BUFFER_SIZE, it does not grow every socket instance. */
+#ifndef SOCKETIO_RECEIVE_BUFFER_SIZE
+#define SOCKETIO_RECEIVE_BUFFER_SIZE    16384
+#endif
+
 MOCKABLE_FUNCTION(, CONCRETE_IO_HANDLE, socketio_create, void*, io_create_parameters);
 MOCKABLE_FUNCTION(, void, socketio_destroy, CONCRETE_IO_HANDLE, socket_io);
 MOCKABLE_FUNCTION(, int, socketio_open, CONCRETE_IO_HANDLE, socket_io, ON_IO_OPEN_COMPLETE, on_io_open_complete, void*, on_io_open_complete_context, ON_BYTES_RECEIVED, on_bytes_received, void*, on_bytes_received_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context);
 MOCKABLE_FUNCTION(, int, socketio_close, CONCRETE_IO_HANDLE, socket_io, ON_IO_CLOSE_COMPLETE, on_io_close_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, int, socketio_send, CONCRETE_IO_HANDLE, socket_io, const void*, buffer, size_t, size, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+/* Sends the buffers with one sendmsg, only an unsent remainder is copied. (socketio_berkeley only) */
+MOCKABLE_FUNCTION(, int, socketio_send_vectored, CONCRETE_IO_HANDLE, socket_io, const XIO_SEND_BUFFER*, buffers, size_t, buffer_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+/* Sends a reference counted buffer without copying it. If the socket cannot take it all at once a reference is held
+   until the remainder has been sent, so the caller may release its own reference on return. (socketio_berkeley only) */
+MOCKABLE_FUNCTION(, int, socketio_send_constbuffer, CONCRETE_IO_HANDLE, socket_io, CONSTBUFFER_HANDLE, buffer, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, void, socketio_dowork, CONCRETE_IO_HANDLE, socket_io);
 MOCKABLE_FUNCTION(, int, socketio_setoption, CONCRETE_IO_HANDLE, socket_io, const char*, optionName, const void*, value);
 
@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures tlsio_openssl receive throughput against a TLS echo server and reports how many on_bytes_received
+// callbacks the echoed bytes arrived in. Any echo server works, for example:
+//     openssl req -x509 -newkey rsa:2048 -nodes -keyout key.pem -out cert.pem -days 1 -subj /CN=localhost
+//     socat OPENSSL-LISTEN:44330,cert=cert.pem,key=key.pem,verify=0,fork,reuseaddr EXEC:cat
+//     tlsio_throughput 127.0.0.1 44330 20
+// The server certificate is not validated.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "openssl/ssl.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/tlsio_openssl.h"
+#include "azure_c_shared_utility/xio.h"
+
+#define SEND_SIZE       65536
+#define SENDS_IN_FLIGHT 4
+
+static int open_result;
+static size_t io_error_count;
+static size_t received_bytes;
+static size_t received_calls;
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT result)
+{
+    (void)context;
+    open_result = (result == IO_OPEN_OK) ? 1 : -1;
+}
+
+static void on_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context, (void)buffer;
+    received_bytes += size;
+    received_calls++;
+}
+
+static void on_io_error(void* context)
+{
+    (void)context;
+    io_error_count++;
+}
+
+static int accept_any_certificate(X509_STORE_CTX* store_context, void* data)
+{
+    (void)store_context, (void)data;
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    TLSIO_CONFIG tlsio_config = { "127.0.0.1", 44330, NULL, NULL };
+    size_t total_bytes = (size_t)20 * 1024 * 1024;
+    size_t receive_buffer_size = 0;
+
+    if (argc > 1)
+    {
+        tlsio_config.hostname = argv[1];
+    }
+    if (argc > 2)
+    {
+        tlsio_config.port = atoi(argv[2]);
+    }
+    if (argc > 3)
+    {
+        total_bytes = (size_t)atol(argv[3]) * 1024 * 1024;
+    }
+    if (argc > 4)
+    {
+        receive_buffer_size = (size_t)atol(argv[4]);
+    }
+
+    if (platform_init() != 0)
+    {
+        (void)printf("Cannot initialize platform.\r\n");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        XIO_HANDLE tlsio = xio_create(tlsio_openssl_get_interface_description(), &tlsio_config);
+        if (tlsio == NULL)
+        {
+            (void)printf("Error creating TLS IO.\r\n");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            void* validation_callback = (void*)accept_any_certificate;
+
+            if (xio_setoption(tlsio, "tls_validation_callback", validation_callback) != 0 ||
+                (receive_buffer_size != 0 && xio_setoption(tlsio, OPTION_TLS_RECEIVE_BUFFER_SIZE, &receive_buffer_size) != 0))
+            {
+                (void)printf("Error setting TLS IO options.\r\n");
+                result = MU_FAILURE;
+            }
+            else if (xio_open(tlsio, on_io_open_complete, NULL, on_io_bytes_received, NULL, on_io_error, NULL) != 0)
+            {
+                (void)printf("Error opening TLS IO.\r\n");
+                result = MU_FAILURE;
+            }
+            else
+            {
+                while (open_result == 0)
+                {
+                    xio_dowork(tlsio);
+                }
+
+                if (open_result < 0)
+                {
+                    (void)printf("Open error.\r\n");
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    static unsigned char to_send[SEND_SIZE];
+                    size_t sent_bytes = 0;
+                    struct timespec start, end;
+                    double seconds;
+
+                    (void)memset(to_send, 'a', sizeof(to_send));
+                    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+                    while (received_bytes < total_bytes && io_error_count == 0)
+                    {
+                        // keep a few sends in flight so the echo server always has data to return
+                        if (sent_bytes < total_bytes && sent_bytes - received_bytes < SENDS_IN_FLIGHT * SEND_SIZE)
+                        {
+                            if (xio_send(tlsio, to_send, sizeof(to_send), NULL, NULL) != 0)
+                            {
+                                (void)printf("Send failed.\r\n");
+                                break;
+                            }
+                            sent_bytes += sizeof(to_send);
+                        }
+                        xio_dowork(tlsio);
+                    }
+
+                    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+                    seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+                    (void)printf("received %lu bytes in %lu callbacks, %.0f bytes per callback, %.1f MB/s\r\n",
+                        (unsigned long)received_bytes, (unsigned long)received_calls,
+                        received_calls > 0 ? (double)received_bytes / (double)received_calls : 0.0,
+                        (double)received_bytes / seconds / 1e6);
+
+                    result = (received_bytes >= total_bytes) ? 0 : MU_FAILURE;
+                }
+
+                (void)xio_close(tlsio, NULL, NULL);
+            }
+
+            xio_destroy(tlsio);
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
@@ -2,6 +2,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xio.h"
@@ -153,6 +154,61 @@ int xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE o
     return result;
 }
 
+int xio_send_vectored(XIO_HANDLE xio, const XIO_SEND_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if (xio == NULL || buffers == NULL || buffer_count == 0)
+    {
+        LogError("Invalid arguments: xio = %p, buffers = %p, buffer_count = %lu", xio, buffers, (unsigned long)buffer_count);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+
+        if (xio_instance->io_interface_description->concrete_io_send_vectored != NULL)
+        {
+            result = xio_instance->io_interface_description->concrete_io_send_vectored(xio_instance->concrete_xio_handle, buffers, buffer_count, on_send_complete, callback_context);
+        }
+        else if (buffer_count == 1)
+        {
+            result = xio_instance->io_interface_description->concrete_io_send(xio_instance->concrete_xio_handle, buffers[0].buffer, buffers[0].size, on_send_complete, callback_context);
+        }
+        else
+        {
+            size_t size = 0;
+            size_t i;
+            unsigned char* gathered;
+
+            for (i = 0; i < buffer_count; i++)
+            {
+                size += buffers[i].size;
+            }
+
+            if ((gathered = (unsigned char*)malloc(size)) == NULL)
+            {
+                LogError("Failure allocating %lu bytes to gather the send buffers", (unsigned long)size);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                size_t offset = 0;
+                for (i = 0; i < buffer_count; i++)
+                {
+                    (void)memcpy(gathered + offset, buffers[i].buffer, buffers[i].size);
+                    offset += buffers[i].size;
+                }
+
+                result = xio_instance->io_interface_description->concrete_io_send(xio_instance->concrete_xio_handle, gathered, size, on_send_complete, callback_context);
+                free(gathered);
+            }
+        }
+    }
+
+    return result;
+}
+
 void xio_dowork(XIO_HANDLE xio)
 {
     /* Codes_SRS_XIO_01_018: [When the handle argument is NULL, xio_dowork shall do nothing.] */
@@ -7,26 +7,691 @@
 #include <stdint.h>
 #endif
 
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+
 #include "testrunnerswitcher.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_stdint.h"
+#include "azure_macro_utils/macro_utils.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
 
 #define ENABLE_MOCKS
 
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/constbuffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, ssize_t, sendmsg, int, sockfd, const struct msghdr*, msg, int, flags);
+    MOCKABLE_FUNCTION(, ssize_t, recv, int, sockfd, void*, buf, size_t, len, int, flags);
+    MOCKABLE_FUNCTION(, int, close, int, sockfd);
+#ifdef __cplusplus
+}
+#endif
 
 #undef ENABLE_MOCKS
 
 #include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/shared_util_options.h"
 
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <netdb.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+    SINGLYLINKEDLIST_HANDLE real_singlylinkedlist_create(void);
+    void real_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list);
+    LIST_ITEM_HANDLE real_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item);
+    int real_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item_handle);
+    LIST_ITEM_HANDLE real_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list);
+    LIST_ITEM_HANDLE real_singlylinkedlist_get_next_item(LIST_ITEM_HANDLE item_handle);
+    const void* real_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle);
+#ifdef __cplusplus
+}
+#endif
+
+#define TEST_SOCKET 42
+#define TEST_CONSTBUFFER_HANDLE ((CONSTBUFFER_HANDLE)0x4242)
+#define TEST_OPTIONHANDLER_HANDLE ((OPTIONHANDLER_HANDLE)0x4243)
+#define TEST_MAX_COMPLETIONS 8
+#define TEST_MAX_RECVS 4
+
+static const unsigned char test_constbuffer_bytes[] = { '0', '1', '2', '3', '4', '5', '6', '7' };
+static const CONSTBUFFER test_constbuffer = { test_constbuffer_bytes, sizeof(test_constbuffer_bytes) };
+
+/* sendmsg accepts up to sendmsg_limit bytes per call, 0 fails the call with EAGAIN */
+static size_t sendmsg_limit;
+static size_t sendmsg_call_count;
+static size_t sendmsg_last_iov_count;
+static unsigned char sent_bytes[256];
+static size_t sent_size;
+
+/* recv returns recv_sizes[n] bytes on call n, then fails with EAGAIN */
+static size_t recv_sizes[TEST_MAX_RECVS];
+static size_t recv_size_count;
+static size_t recv_call_count;
+static size_t recv_last_len;
+static size_t received_size;
+
+static size_t constbuffer_refs;
+
+static pfCloneOption option_clone;
+static pfDestroyOption option_destroy;
+static size_t added_receive_buffer_size;
+static size_t watch_changed_count;
+
+static void* completion_contexts[TEST_MAX_COMPLETIONS];
+static IO_SEND_RESULT completion_results[TEST_MAX_COMPLETIONS];
+static size_t completion_count;
+
+static ssize_t my_sendmsg(int sockfd, const struct msghdr* msg, int flags)
+{
+    ssize_t result;
+    size_t sent = 0;
+    size_t i;
+    (void)sockfd;
+    (void)flags;
+
+    sendmsg_call_count++;
+    sendmsg_last_iov_count = (size_t)msg->msg_iovlen;
+
+    for (i = 0; i < (size_t)msg->msg_iovlen && sent < sendmsg_limit; i++)
+    {
+        size_t length = msg->msg_iov[i].iov_len;
+        if (length > sendmsg_limit - sent)
+        {
+            length = sendmsg_limit - sent;
+        }
+        (void)memcpy(sent_bytes + sent_size, msg->msg_iov[i].iov_base, length);
+        sent_size += length;
+        sent += length;
+    }
+
+    if (sent == 0)
+    {
+        errno = EAGAIN;
+        result = -1;
+    }
+    else
+    {
+        result = (ssize_t)sent;
+    }
+
+    return result;
+}
+
+static ssize_t my_recv(int sockfd, void* buf, size_t len, int flags)
+{
+    ssize_t result;
+    (void)sockfd;
+    (void)flags;
+
+    recv_last_len = len;
+    if (recv_call_count < recv_size_count)
+    {
+        ASSERT_IS_TRUE(recv_sizes[recv_call_count] <= len);
+        (void)memset(buf, 'r', recv_sizes[recv_call_count]);
+        result = (ssize_t)recv_sizes[recv_call_count];
+    }
+    else
+    {
+        errno = EAGAIN;
+        result = -1;
+    }
+    recv_call_count++;
+
+    return result;
+}
+
+static OPTIONHANDLER_HANDLE my_OptionHandler_Create(pfCloneOption cloneOption, pfDestroyOption destroyOption, pfSetOption setOption)
+{
+    (void)setOption;
+    option_clone = cloneOption;
+    option_destroy = destroyOption;
+    return TEST_OPTIONHANDLER_HANDLE;
+}
+
+static OPTIONHANDLER_RESULT my_OptionHandler_AddOption(OPTIONHANDLER_HANDLE handle, const char* name, const void* value)
+{
+    (void)handle;
+    if (strcmp(name, OPTION_SOCKET_RECEIVE_BUFFER_SIZE) == 0)
+    {
+        added_receive_buffer_size = *(const size_t*)value;
+    }
+    return OPTIONHANDLER_OK;
+}
+
+static void my_CONSTBUFFER_IncRef(CONSTBUFFER_HANDLE constbufferHandle)
+{
+    (void)constbufferHandle;
+    constbuffer_refs++;
+}
+
+static void my_CONSTBUFFER_DecRef(CONSTBUFFER_HANDLE constbufferHandle)
+{
+    (void)constbufferHandle;
+    ASSERT_ARE_NOT_EQUAL(size_t, 0, constbuffer_refs);
+    constbuffer_refs--;
+}
+
+static const CONSTBUFFER* my_CONSTBUFFER_GetContent(CONSTBUFFER_HANDLE constbufferHandle)
+{
+    (void)constbufferHandle;
+    return &test_constbuffer;
+}
+
+static void test_on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    ASSERT_IS_TRUE(completion_count < TEST_MAX_COMPLETIONS);
+    completion_contexts[completion_count] = context;
+    completion_results[completion_count] = send_result;
+    completion_count++;
+}
+
+static void test_on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    (void)open_result;
+}
+
+static void test_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    (void)buffer;
+    received_size += size;
+}
+
+static void test_on_watch_changed(void* context, int socket, int send_pending)
+{
+    (void)context;
+    (void)socket;
+    (void)send_pending;
+    watch_changed_count++;
+}
+
+static void test_on_io_error(void* context)
+{
+    (void)context;
+}
+
+static CONCRETE_IO_HANDLE create_open_accepted_socket(void)
+{
+    int accepted_socket = TEST_SOCKET;
+    SOCKETIO_CONFIG config = { NULL, 0, &accepted_socket };
+    CONCRETE_IO_HANDLE result = socketio_create(&config);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, socketio_open(result, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL));
+    return result;
+}
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%" PRI_MU_ENUM "", MU_ENUM_VALUE(UMOCK_C_ERROR_CODE, error_code));
+}
 
 TEST_MUTEX_HANDLE test_serialize_mutex;
 
 BEGIN_TEST_SUITE(socketio_berkeley_unittests)
 
+TEST_SUITE_INITIALIZE(socketio_send_suite_init)
+{
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    ASSERT_ARE_EQUAL(int, 0, umock_c_init(on_umock_c_error));
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_charptr_register_types());
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_stdint_register_types());
+
+    if (sizeof(ssize_t) == sizeof(int32_t))
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(ssize_t, int32_t);
+    }
+    else
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(ssize_t, int64_t);
+    }
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_calloc, my_gballoc_calloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, real_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, real_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, real_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_next_item, real_singlylinkedlist_get_next_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, real_singlylinkedlist_item_get_value);
+
+    REGISTER_GLOBAL_MOCK_HOOK(CONSTBUFFER_IncRef, my_CONSTBUFFER_IncRef);
+    REGISTER_GLOBAL_MOCK_HOOK(CONSTBUFFER_DecRef, my_CONSTBUFFER_DecRef);
+    REGISTER_GLOBAL_MOCK_HOOK(CONSTBUFFER_GetContent, my_CONSTBUFFER_GetContent);
+
+    REGISTER_GLOBAL_MOCK_HOOK(OptionHandler_Create, my_OptionHandler_Create);
+    REGISTER_GLOBAL_MOCK_HOOK(OptionHandler_AddOption, my_OptionHandler_AddOption);
+
+    REGISTER_GLOBAL_MOCK_HOOK(sendmsg, my_sendmsg);
+    REGISTER_GLOBAL_MOCK_HOOK(recv, my_recv);
+    REGISTER_GLOBAL_MOCK_RETURN(close, 0);
+}
+
+TEST_SUITE_CLEANUP(socketio_send_suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(socketio_send_method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+
+    sendmsg_limit = sizeof(sent_bytes);
+    sendmsg_call_count = 0;
+    sendmsg_last_iov_count = 0;
+    sent_size = 0;
+    recv_size_count = 0;
+    recv_call_count = 0;
+    recv_last_len = 0;
+    received_size = 0;
+    constbuffer_refs = 0;
+    completion_count = 0;
+    option_clone = NULL;
+    option_destroy = NULL;
+    added_receive_buffer_size = 0;
+    watch_changed_count = 0;
+}
+
+TEST_FUNCTION_CLEANUP(socketio_send_method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+TEST_FUNCTION(socketio_send_vectored_sends_all_buffers_with_one_sendmsg)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    XIO_SEND_BUFFER buffers[3] = { { "ab", 2 }, { "cde", 3 }, { "f", 1 } };
+    int context = 1;
+
+    // act
+    int result = socketio_send_vectored(socket_io, buffers, 3, test_on_send_complete, &context);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, 3, sendmsg_last_iov_count);
+    ASSERT_ARE_EQUAL(size_t, 6, sent_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_bytes, "abcdef", 6));
+    ASSERT_ARE_EQUAL(size_t, 1, completion_count);
+    ASSERT_ARE_EQUAL(void_ptr, &context, completion_contexts[0]);
+    ASSERT_ARE_EQUAL(int, IO_SEND_OK, completion_results[0]);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_flushes_the_pending_chain_with_one_sendmsg)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    int contexts[3];
+    sendmsg_limit = 0;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send(socket_io, "abc", 3, test_on_send_complete, &contexts[0]));
+    ASSERT_ARE_EQUAL(int, 0, socketio_send(socket_io, "de", 2, test_on_send_complete, &contexts[1]));
+    ASSERT_ARE_EQUAL(int, 0, socketio_send(socket_io, "fgh", 3, test_on_send_complete, &contexts[2]));
+    ASSERT_ARE_EQUAL(size_t, 1, sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, 0, completion_count);
+    sendmsg_limit = sizeof(sent_bytes);
+    sendmsg_call_count = 0;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, 3, sendmsg_last_iov_count);
+    ASSERT_ARE_EQUAL(size_t, 8, sent_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_bytes, "abcdefgh", 8));
+    ASSERT_ARE_EQUAL(size_t, 3, completion_count);
+    ASSERT_ARE_EQUAL(void_ptr, &contexts[0], completion_contexts[0]);
+    ASSERT_ARE_EQUAL(void_ptr, &contexts[1], completion_contexts[1]);
+    ASSERT_ARE_EQUAL(void_ptr, &contexts[2], completion_contexts[2]);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_resumes_a_partial_send_at_its_offset)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    int contexts[2];
+    sendmsg_limit = 2;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send(socket_io, "abcdef", 6, test_on_send_complete, &contexts[0]));
+    ASSERT_ARE_EQUAL(int, 0, socketio_send(socket_io, "ghij", 4, test_on_send_complete, &contexts[1]));
+    sendmsg_limit = 3;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 5, sent_size);
+    ASSERT_ARE_EQUAL(size_t, 0, completion_count);
+
+    // act
+    sendmsg_limit = sizeof(sent_bytes);
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, sendmsg_last_iov_count);
+    ASSERT_ARE_EQUAL(size_t, 10, sent_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_bytes, "abcdefghij", 10));
+    ASSERT_ARE_EQUAL(size_t, 2, completion_count);
+    ASSERT_ARE_EQUAL(void_ptr, &contexts[0], completion_contexts[0]);
+    ASSERT_ARE_EQUAL(void_ptr, &contexts[1], completion_contexts[1]);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_completes_a_partial_write_split_across_buffers)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    int contexts[2];
+    sendmsg_limit = 0;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send(socket_io, "abc", 3, test_on_send_complete, &contexts[0]));
+    ASSERT_ARE_EQUAL(int, 0, socketio_send(socket_io, "defg", 4, test_on_send_complete, &contexts[1]));
+    sendmsg_limit = 5;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, completion_count);
+    ASSERT_ARE_EQUAL(void_ptr, &contexts[0], completion_contexts[0]);
+
+    // act
+    sendmsg_limit = sizeof(sent_bytes);
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, sendmsg_last_iov_count);
+    ASSERT_ARE_EQUAL(size_t, 7, sent_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_bytes, "abcdefg", 7));
+    ASSERT_ARE_EQUAL(size_t, 2, completion_count);
+    ASSERT_ARE_EQUAL(void_ptr, &contexts[1], completion_contexts[1]);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_send_constbuffer_sent_at_once_takes_no_reference)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(sendmsg(TEST_SOCKET, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+
+    // act
+    int result = socketio_send_constbuffer(socket_io, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_constbuffer_bytes), sent_size);
+    ASSERT_ARE_EQUAL(size_t, 1, completion_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_send_constbuffer_queued_references_the_buffer_until_sent)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    sendmsg_limit = 3;
+
+    // act
+    int result = socketio_send_constbuffer(socket_io, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, constbuffer_refs);
+    ASSERT_ARE_EQUAL(size_t, 0, completion_count);
+
+    // act
+    sendmsg_limit = sizeof(sent_bytes);
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, constbuffer_refs);
+    ASSERT_ARE_EQUAL(size_t, 1, completion_count);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_constbuffer_bytes), sent_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(sent_bytes, test_constbuffer_bytes, sizeof(test_constbuffer_bytes)));
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_destroy_releases_a_queued_constbuffer)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    sendmsg_limit = 0;
+    ASSERT_ARE_EQUAL(int, 0, socketio_send_constbuffer(socket_io, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, NULL));
+    ASSERT_ARE_EQUAL(size_t, 1, constbuffer_refs);
+
+    // act
+    socketio_destroy(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, constbuffer_refs);
+    ASSERT_ARE_EQUAL(size_t, 0, completion_count);
+}
+
+TEST_FUNCTION(socketio_dowork_receives_into_the_default_buffer_size)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, recv_call_count);
+    ASSERT_ARE_EQUAL(size_t, SOCKETIO_RECEIVE_BUFFER_SIZE, recv_last_len);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_setoption_receive_buffer_size_sets_the_recv_size)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    size_t receive_buffer_size = 1000;
+    recv_sizes[0] = 1000;
+    recv_sizes[1] = 500;
+    recv_size_count = 2;
+
+    // act
+    int result = socketio_setoption(socket_io, OPTION_SOCKET_RECEIVE_BUFFER_SIZE, &receive_buffer_size);
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 3, recv_call_count);
+    ASSERT_ARE_EQUAL(size_t, 1000, recv_last_len);
+    ASSERT_ARE_EQUAL(size_t, 1500, received_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_setoption_receive_buffer_size_0_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    size_t receive_buffer_size = 0;
+
+    // act
+    int result = socketio_setoption(socket_io, OPTION_SOCKET_RECEIVE_BUFFER_SIZE, &receive_buffer_size);
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, SOCKETIO_RECEIVE_BUFFER_SIZE, recv_last_len);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_retrieveoptions_saves_the_receive_buffer_size)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    size_t receive_buffer_size = 1000;
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_SOCKET_RECEIVE_BUFFER_SIZE, &receive_buffer_size));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, OPTION_SOCKET_RECEIVE_BUFFER_SIZE, IGNORED_PTR_ARG));
+
+    // act
+    OPTIONHANDLER_HANDLE result = socketio_get_interface_description()->concrete_io_retrieveoptions(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1000, added_receive_buffer_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_retrieveoptions_skips_the_default_receive_buffer_size)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    OPTIONHANDLER_HANDLE result = socketio_get_interface_description()->concrete_io_retrieveoptions(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_clone_and_destroy_receive_buffer_size_option)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    size_t receive_buffer_size = 1000;
+    (void)socketio_get_interface_description()->concrete_io_retrieveoptions(socket_io);
+    ASSERT_IS_NOT_NULL(option_clone);
+
+    // act
+    size_t* result = (size_t*)option_clone(OPTION_SOCKET_RECEIVE_BUFFER_SIZE, &receive_buffer_size);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &receive_buffer_size, result);
+    ASSERT_ARE_EQUAL(size_t, 1000, *result);
+
+    // cleanup
+    option_destroy(OPTION_SOCKET_RECEIVE_BUFFER_SIZE, result);
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_without_a_socket_watch_reads_until_EAGAIN_after_a_short_read)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    recv_sizes[0] = 10;
+    recv_size_count = 1;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, recv_call_count);
+    ASSERT_ARE_EQUAL(size_t, 10, received_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_dowork_with_a_socket_watch_stops_after_a_short_read)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_accepted_socket();
+    SOCKETIO_WATCH watch = { test_on_watch_changed, NULL };
+    size_t receive_buffer_size = 100;
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_SOCKET_RECEIVE_BUFFER_SIZE, &receive_buffer_size));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_SOCKET_WATCH, &watch));
+    ASSERT_ARE_EQUAL(size_t, 1, watch_changed_count);
+    recv_sizes[0] = 100;
+    recv_sizes[1] = 10;
+    recv_size_count = 2;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, recv_call_count);
+    ASSERT_ARE_EQUAL(size_t, 110, received_size);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
 #if 0
 
 // SOCKETIO_SETOPTION TESTS WERE WORKING BEFORE SWITCH TO umock_c...need to finish the conversion
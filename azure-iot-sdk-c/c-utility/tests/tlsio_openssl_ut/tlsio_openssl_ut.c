@@ -0,0 +1,573 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <climits>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <limits.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_stdint.h"
+#include "azure_macro_utils/macro_utils.h"
+
+#include "openssl/ssl.h"
+#include "openssl/bio.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/x509_openssl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    /* the rest of OpenSSL is used for real, these three stand in for the handshake and the record layer */
+    MOCKABLE_FUNCTION(, int, SSL_do_handshake, SSL*, s);
+    MOCKABLE_FUNCTION(, int, SSL_write, SSL*, ssl, const void*, buf, int, num);
+    MOCKABLE_FUNCTION(, int, SSL_read, SSL*, ssl, void*, buf, int, num);
+#ifdef __cplusplus
+}
+#endif
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/tlsio_openssl.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+#define TEST_XIO_HANDLE ((XIO_HANDLE)0x4242)
+#define TEST_INTERFACE_DESCRIPTION ((const IO_INTERFACE_DESCRIPTION*)0x4243)
+#define TEST_OPTIONHANDLER_HANDLE ((OPTIONHANDLER_HANDLE)0x4244)
+#define TEST_UNDERLYING_OPTIONHANDLER_HANDLE ((OPTIONHANDLER_HANDLE)0x4245)
+#define TEST_RECORD_SIZE 16384
+#define TEST_MAX_RECEIVE_CALLS 8
+
+static unsigned char test_large_buffer[TEST_RECORD_SIZE + 100];
+
+/* SSL_write fails on call number ssl_write_fail_call, 0 never fails */
+static size_t ssl_write_call_count;
+static size_t ssl_write_fail_call;
+static SSL* ssl_write_last_ssl;
+
+/* SSL_read returns at most ssl_read_record_size bytes per call, as it would one decrypted record at a time */
+static size_t ssl_read_record_size;
+static size_t ssl_read_call_count;
+
+static ON_IO_OPEN_COMPLETE underlying_on_io_open_complete;
+static void* underlying_on_io_open_complete_context;
+static ON_BYTES_RECEIVED underlying_on_bytes_received;
+static void* underlying_on_bytes_received_context;
+
+static size_t xio_send_call_count;
+static unsigned char xio_sent_bytes[2 * TEST_RECORD_SIZE];
+static size_t xio_sent_size;
+
+static size_t io_error_count;
+
+static unsigned char received_bytes[4 * TEST_RECORD_SIZE];
+static size_t received_size;
+static size_t received_call_count;
+static size_t received_call_sizes[TEST_MAX_RECEIVE_CALLS];
+
+static pfCloneOption option_clone;
+static pfDestroyOption option_destroy;
+static size_t added_receive_buffer_size;
+
+/* writes the plaintext to the out BIO in place of the encrypted record */
+static int my_SSL_write(SSL* ssl, const void* buf, int num)
+{
+    int result;
+
+    ssl_write_call_count++;
+    ssl_write_last_ssl = ssl;
+    if (ssl_write_call_count == ssl_write_fail_call)
+    {
+        result = -1;
+    }
+    else
+    {
+        result = BIO_write(SSL_get_wbio(ssl), buf, num);
+    }
+
+    return result;
+}
+
+/* reads the plaintext the test fed to the in BIO, one record at a time */
+static int my_SSL_read(SSL* ssl, void* buf, int num)
+{
+    int result;
+    int record_size = (int)ssl_read_record_size;
+
+    ssl_read_call_count++;
+    ASSERT_IS_TRUE(num > 0);
+
+    result = BIO_read(SSL_get_rbio(ssl), buf, num < record_size ? num : record_size);
+
+    return result > 0 ? result : -1;
+}
+
+static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)xio;
+    (void)on_io_error;
+    (void)on_io_error_context;
+    underlying_on_io_open_complete = on_io_open_complete;
+    underlying_on_io_open_complete_context = on_io_open_complete_context;
+    underlying_on_bytes_received = on_bytes_received;
+    underlying_on_bytes_received_context = on_bytes_received_context;
+    return 0;
+}
+
+static int my_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    (void)xio;
+    (void)on_send_complete;
+    (void)callback_context;
+    ASSERT_IS_TRUE(xio_sent_size + size <= sizeof(xio_sent_bytes));
+    (void)memcpy(xio_sent_bytes + xio_sent_size, buffer, size);
+    xio_sent_size += size;
+    xio_send_call_count++;
+    return 0;
+}
+
+static void test_on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    ASSERT_ARE_EQUAL(int, IO_OPEN_OK, open_result);
+}
+
+static OPTIONHANDLER_HANDLE my_OptionHandler_Create(pfCloneOption cloneOption, pfDestroyOption destroyOption, pfSetOption setOption)
+{
+    (void)setOption;
+    option_clone = cloneOption;
+    option_destroy = destroyOption;
+    return TEST_OPTIONHANDLER_HANDLE;
+}
+
+static OPTIONHANDLER_RESULT my_OptionHandler_AddOption(OPTIONHANDLER_HANDLE handle, const char* name, const void* value)
+{
+    (void)handle;
+    if (strcmp(name, OPTION_TLS_RECEIVE_BUFFER_SIZE) == 0)
+    {
+        added_receive_buffer_size = *(const size_t*)value;
+    }
+    return OPTIONHANDLER_OK;
+}
+
+static void test_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    ASSERT_IS_TRUE(received_size + size <= sizeof(received_bytes));
+    ASSERT_IS_TRUE(received_call_count < TEST_MAX_RECEIVE_CALLS);
+    (void)memcpy(received_bytes + received_size, buffer, size);
+    received_size += size;
+    received_call_sizes[received_call_count++] = size;
+}
+
+static void test_on_io_error(void* context)
+{
+    (void)context;
+    io_error_count++;
+}
+
+static CONCRETE_IO_HANDLE create_open_tlsio(void)
+{
+    TLSIO_CONFIG config;
+    CONCRETE_IO_HANDLE result;
+
+    (void)memset(&config, 0, sizeof(config));
+    config.hostname = "test.azure-devices.net";
+    config.port = 8883;
+    config.underlying_io_interface = TEST_INTERFACE_DESCRIPTION;
+
+    result = tlsio_openssl_create(&config);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_open(result, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL));
+    ASSERT_IS_NOT_NULL(underlying_on_io_open_complete);
+    underlying_on_io_open_complete(underlying_on_io_open_complete_context, IO_OPEN_OK);
+
+    umock_c_reset_all_calls();
+    return result;
+}
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%" PRI_MU_ENUM "", MU_ENUM_VALUE(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+BEGIN_TEST_SUITE(tlsio_openssl_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    size_t i;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    ASSERT_ARE_EQUAL(int, 0, umock_c_init(on_umock_c_error));
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_charptr_register_types());
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_stdint_register_types());
+
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_calloc, my_gballoc_calloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(xio_create, TEST_XIO_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_send, my_xio_send);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_close, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_retrieveoptions, TEST_UNDERLYING_OPTIONHANDLER_HANDLE);
+
+    REGISTER_GLOBAL_MOCK_HOOK(OptionHandler_Create, my_OptionHandler_Create);
+    REGISTER_GLOBAL_MOCK_HOOK(OptionHandler_AddOption, my_OptionHandler_AddOption);
+
+    REGISTER_GLOBAL_MOCK_RETURN(SSL_do_handshake, 1);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_write, my_SSL_write);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_read, my_SSL_read);
+
+    for (i = 0; i < sizeof(test_large_buffer); i++)
+    {
+        test_large_buffer[i] = (unsigned char)i;
+    }
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+
+    ssl_write_call_count = 0;
+    ssl_write_fail_call = 0;
+    ssl_write_last_ssl = NULL;
+    ssl_read_record_size = TEST_RECORD_SIZE;
+    ssl_read_call_count = 0;
+    underlying_on_io_open_complete = NULL;
+    underlying_on_io_open_complete_context = NULL;
+    underlying_on_bytes_received = NULL;
+    underlying_on_bytes_received_context = NULL;
+    xio_send_call_count = 0;
+    xio_sent_size = 0;
+    io_error_count = 0;
+    received_size = 0;
+    received_call_count = 0;
+    option_clone = NULL;
+    option_destroy = NULL;
+    added_receive_buffer_size = 0;
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(tlsio_openssl_send_vectored_coalesces_small_buffers_into_one_record)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    XIO_SEND_BUFFER buffers[2] = { { "ab", 2 }, { "cde", 3 } };
+
+    // act
+    int result = tlsio_openssl_send_vectored(tls_io, buffers, 2, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, ssl_write_call_count);
+    ASSERT_ARE_EQUAL(size_t, 1, xio_send_call_count);
+    ASSERT_ARE_EQUAL(size_t, 5, xio_sent_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(xio_sent_bytes, "abcde", 5));
+
+    // cleanup
+    tlsio_openssl_destroy(tls_io);
+}
+
+TEST_FUNCTION(tlsio_openssl_send_vectored_failure_after_a_record_was_encrypted_indicates_error)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    XIO_SEND_BUFFER buffers[2] = { { test_large_buffer, sizeof(test_large_buffer) }, { "tail", 4 } };
+    ssl_write_fail_call = 2;
+
+    // act
+    int result = tlsio_openssl_send_vectored(tls_io, buffers, 2, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, ssl_write_call_count);
+    ASSERT_ARE_EQUAL(size_t, 1, io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 0, xio_send_call_count);
+    ASSERT_ARE_EQUAL(size_t, 0, BIO_ctrl_pending(SSL_get_wbio(ssl_write_last_ssl)));
+
+    // act
+    tlsio_openssl_dowork(tls_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, xio_send_call_count);
+    ASSERT_ARE_NOT_EQUAL(int, 0, tlsio_openssl_send(tls_io, "next", 4, NULL, NULL));
+
+    // cleanup
+    tlsio_openssl_destroy(tls_io);
+}
+
+TEST_FUNCTION(tlsio_openssl_send_vectored_failure_before_any_record_keeps_the_connection)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    XIO_SEND_BUFFER first = { "abc", 3 };
+    XIO_SEND_BUFFER second = { "def", 3 };
+    ssl_write_fail_call = 1;
+
+    // act
+    int result = tlsio_openssl_send_vectored(tls_io, &first, 1, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 0, xio_send_call_count);
+
+    // act
+    result = tlsio_openssl_send_vectored(tls_io, &second, 1, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, xio_send_call_count);
+    ASSERT_ARE_EQUAL(size_t, 3, xio_sent_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(xio_sent_bytes, "def", 3));
+
+    // cleanup
+    tlsio_openssl_destroy(tls_io);
+}
+
+TEST_FUNCTION(tlsio_openssl_on_bytes_received_coalesces_available_records_into_one_call)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    ssl_read_record_size = 100;
+
+    // act
+    underlying_on_bytes_received(underlying_on_bytes_received_context, test_large_buffer, 350);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 5, ssl_read_call_count);
+    ASSERT_ARE_EQUAL(size_t, 1, received_call_count);
+    ASSERT_ARE_EQUAL(size_t, 350, received_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(received_bytes, test_large_buffer, 350));
+    ASSERT_ARE_EQUAL(size_t, 0, io_error_count);
+
+    // cleanup
+    tlsio_openssl_destroy(tls_io);
+}
+
+TEST_FUNCTION(tlsio_openssl_on_bytes_received_passes_up_a_full_buffer_and_continues)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    size_t receive_buffer_size = 256;
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_setoption(tls_io, OPTION_TLS_RECEIVE_BUFFER_SIZE, &receive_buffer_size));
+    ssl_read_record_size = 100;
+
+    // act
+    underlying_on_bytes_received(underlying_on_bytes_received_context, test_large_buffer, 600);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 3, received_call_count);
+    ASSERT_ARE_EQUAL(size_t, 256, received_call_sizes[0]);
+    ASSERT_ARE_EQUAL(size_t, 256, received_call_sizes[1]);
+    ASSERT_ARE_EQUAL(size_t, 88, received_call_sizes[2]);
+    ASSERT_ARE_EQUAL(size_t, 600, received_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(received_bytes, test_large_buffer, 600));
+
+    // cleanup
+    tlsio_openssl_destroy(tls_io);
+}
+
+TEST_FUNCTION(tlsio_openssl_on_bytes_received_exactly_filling_the_buffer_makes_no_empty_call)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    size_t receive_buffer_size = 256;
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_setoption(tls_io, OPTION_TLS_RECEIVE_BUFFER_SIZE, &receive_buffer_size));
+    ssl_read_record_size = 128;
+
+    // act
+    underlying_on_bytes_received(underlying_on_bytes_received_context, test_large_buffer, 512);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, received_call_count);
+    ASSERT_ARE_EQUAL(size_t, 256, received_call_sizes[0]);
+    ASSERT_ARE_EQUAL(size_t, 256, received_call_sizes[1]);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(received_bytes, test_large_buffer, 512));
+
+    // cleanup
+    tlsio_openssl_destroy(tls_io);
+}
+
+TEST_FUNCTION(tlsio_openssl_setoption_receive_buffer_size_0_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    size_t receive_buffer_size = 0;
+
+    // act
+    int result = tlsio_openssl_setoption(tls_io, OPTION_TLS_RECEIVE_BUFFER_SIZE, &receive_buffer_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // the default buffer is still used
+    underlying_on_bytes_received(underlying_on_bytes_received_context, test_large_buffer, 1000);
+    ASSERT_ARE_EQUAL(size_t, 1, received_call_count);
+    ASSERT_ARE_EQUAL(size_t, 1000, received_size);
+
+    // cleanup
+    tlsio_openssl_destroy(tls_io);
+}
+
+TEST_FUNCTION(tlsio_openssl_setoption_receive_buffer_size_above_INT_MAX_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    size_t receive_buffer_size = (size_t)INT_MAX;
+    size_t too_large = (size_t)INT_MAX + 1;
+
+    // act
+    int result_int_max = tlsio_openssl_setoption(tls_io, OPTION_TLS_RECEIVE_BUFFER_SIZE, &receive_buffer_size);
+    int result_too_large = (too_large > (size_t)INT_MAX) ? tlsio_openssl_setoption(tls_io, OPTION_TLS_RECEIVE_BUFFER_SIZE, &too_large) : MU_FAILURE;
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result_int_max);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_too_large);
+
+    // cleanup
+    tlsio_openssl_destroy(tls_io);
+}
+
+TEST_FUNCTION(tlsio_openssl_retrieveoptions_saves_the_receive_buffer_size)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    size_t receive_buffer_size = 4096;
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_setoption(tls_io, OPTION_TLS_RECEIVE_BUFFER_SIZE, &receive_buffer_size));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_XIO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "underlying_io_options", TEST_UNDERLYING_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, OPTION_TLS_VERSION, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, OPTION_TLS_RECEIVE_BUFFER_SIZE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_UNDERLYING_OPTIONHANDLER_HANDLE));
+
+    // act
+    OPTIONHANDLER_HANDLE result = tlsio_openssl_get_interface_description()->concrete_io_retrieveoptions(tls_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 4096, added_receive_buffer_size);
+
+    // cleanup
+    tlsio_openssl_destroy(tls_io);
+}
+
+TEST_FUNCTION(tlsio_openssl_retrieveoptions_skips_the_default_receive_buffer_size)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_XIO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "underlying_io_options", TEST_UNDERLYING_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, OPTION_TLS_VERSION, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_UNDERLYING_OPTIONHANDLER_HANDLE));
+
+    // act
+    OPTIONHANDLER_HANDLE result = tlsio_openssl_get_interface_description()->concrete_io_retrieveoptions(tls_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    tlsio_openssl_destroy(tls_io);
+}
+
+TEST_FUNCTION(tlsio_openssl_clone_and_destroy_receive_buffer_size_option)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    size_t receive_buffer_size = 4096;
+    (void)tlsio_openssl_get_interface_description()->concrete_io_retrieveoptions(tls_io);
+    ASSERT_IS_NOT_NULL(option_clone);
+
+    // act
+    size_t* result = (size_t*)option_clone(OPTION_TLS_RECEIVE_BUFFER_SIZE, &receive_buffer_size);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &receive_buffer_size, result);
+    ASSERT_ARE_EQUAL(size_t, 4096, *result);
+
+    // cleanup
+    option_destroy(OPTION_TLS_RECEIVE_BUFFER_SIZE, result);
+    tlsio_openssl_destroy(tls_io);
+}
+
+END_TEST_SUITE(tlsio_openssl_ut)
@@ -52,6 +52,8 @@ MOCK_FUNCTION_WITH_CODE(, int, test_xio_send, CONCRETE_IO_HANDLE, handle, const
 MOCK_FUNCTION_END(0)
 MOCK_FUNCTION_WITH_CODE(, void, test_xio_dowork, CONCRETE_IO_HANDLE, handle)
 MOCK_FUNCTION_END()
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_send_vectored, CONCRETE_IO_HANDLE, handle, const XIO_SEND_BUFFER*, buffers, size_t, buffer_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context)
+MOCK_FUNCTION_END(0)
 MOCK_FUNCTION_WITH_CODE(, int, test_xio_setoption, CONCRETE_IO_HANDLE, handle, const char*, optionName, const void*, value)
 MOCK_FUNCTION_END(0)
 
@@ -114,6 +116,19 @@ const IO_INTERFACE_DESCRIPTION test_io_description =
     test_xio_setoption
 };
 
+const IO_INTERFACE_DESCRIPTION test_io_description_vectored =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    test_xio_send_vectored
+};
+
 static TEST_MUTEX_HANDLE g_testByTest;
 
 MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
@@ -770,6 +785,118 @@ TEST_FUNCTION(xio_send_with_non_NULL_buffer_and_zero_length_passes_the_args_down
     xio_destroy(handle);
 }
 
+/* xio_send_vectored */
+
+TEST_FUNCTION(xio_send_vectored_calls_the_underlying_concrete_xio_send_vectored_and_succeeds)
+{
+    // arrange
+    int result;
+    unsigned char header[] = { 0x30, 0x02 };
+    unsigned char payload[] = { 0x42, 43 };
+    XIO_SEND_BUFFER buffers[2] = { { header, sizeof(header) }, { payload, sizeof(payload) } };
+    XIO_HANDLE handle = xio_create(&test_io_description_vectored, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_send_vectored(TEST_CONCRETE_IO_HANDLE, buffers, 2, test_on_send_complete, (void*)0x4242));
+
+    // act
+    result = xio_send_vectored(handle, buffers, 2, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+TEST_FUNCTION(xio_send_vectored_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+    unsigned char payload[] = { 0x42, 43 };
+    XIO_SEND_BUFFER buffers[1] = { { payload, sizeof(payload) } };
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_send_vectored(NULL, buffers, 1, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(xio_send_vectored_with_one_buffer_and_no_concrete_send_vectored_calls_concrete_xio_send)
+{
+    // arrange
+    int result;
+    unsigned char payload[] = { 0x42, 43 };
+    XIO_SEND_BUFFER buffers[1] = { { payload, sizeof(payload) } };
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, payload, sizeof(payload), test_on_send_complete, (void*)0x4242));
+
+    // act
+    result = xio_send_vectored(handle, buffers, 1, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+TEST_FUNCTION(xio_send_vectored_with_no_concrete_send_vectored_gathers_the_buffers_into_one_concrete_xio_send)
+{
+    // arrange
+    int result;
+    unsigned char header[] = { 0x30, 0x02 };
+    unsigned char payload[] = { 0x42, 43 };
+    XIO_SEND_BUFFER buffers[2] = { { header, sizeof(header) }, { payload, sizeof(payload) } };
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(4));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, IGNORED_PTR_ARG, 4, test_on_send_complete, (void*)0x4242));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = xio_send_vectored(handle, buffers, 2, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+TEST_FUNCTION(when_gathering_the_buffers_fails_then_xio_send_vectored_fails)
+{
+    // arrange
+    int result;
+    unsigned char header[] = { 0x30, 0x02 };
+    unsigned char payload[] = { 0x42, 43 };
+    XIO_SEND_BUFFER buffers[2] = { { header, sizeof(header) }, { payload, sizeof(payload) } };
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(4))
+        .SetReturn(NULL);
+
+    // act
+    result = xio_send_vectored(handle, buffers, 2, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
 /* xio_dowork */
 
 /* Tests_SRS_XIO_01_012: [xio_dowork shall call the concrete IO implementation specified in xio_create, by calling the concrete_xio_dowork function.] */
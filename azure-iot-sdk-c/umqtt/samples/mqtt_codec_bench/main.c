@@ -0,0 +1,208 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures mqtt_codec_bytesReceived decode throughput over captured MQTT packets. The captures are concatenated into
+// one stream that is handed to the decoder in reads of several sizes, as socket or TLS reads would deliver it.
+// The iothub_client fuzz corpus holds a capture of each packet the device client receives, for example:
+//     mqtt_codec_bench iothub_client/tests/iothubclient_fuzz_mqtt/*/*.bin
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "azure_macro_utils/macro_utils.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_umqtt_c/mqtt_codec.h"
+
+#define STREAM_SIZE     (4 * 1024 * 1024)
+#define STREAM_PASSES   8
+
+static const size_t read_sizes[] = { 1, 64, 1460, 16384 };
+
+static size_t packet_count;
+
+static void on_packet_complete(void* context, CONTROL_PACKET_TYPE packet, int flags, BUFFER_HANDLE headerData)
+{
+    (void)context, (void)packet, (void)flags, (void)headerData;
+    packet_count++;
+}
+
+static unsigned char* read_capture(const char* path, size_t* size)
+{
+    unsigned char* result = NULL;
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        (void)printf("Cannot open %s.\r\n", path);
+    }
+    else
+    {
+        long length;
+
+        if (fseek(file, 0, SEEK_END) != 0 || (length = ftell(file)) <= 0 || fseek(file, 0, SEEK_SET) != 0)
+        {
+            (void)printf("Cannot read %s.\r\n", path);
+        }
+        else if ((result = (unsigned char*)malloc((size_t)length)) == NULL)
+        {
+            (void)printf("Cannot allocate %ld bytes for %s.\r\n", length, path);
+        }
+        else if (fread(result, 1, (size_t)length, file) != (size_t)length)
+        {
+            (void)printf("Cannot read %s.\r\n", path);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            *size = (size_t)length;
+        }
+
+        (void)fclose(file);
+    }
+
+    return result;
+}
+
+// Feeds the stream to a new decoder read_size bytes at a time, returns non-zero if the decoder reports an error
+static int decode_stream(const unsigned char* stream, size_t stream_size, size_t read_size, size_t passes)
+{
+    int result = 0;
+    MQTTCODEC_HANDLE codec = mqtt_codec_create(on_packet_complete, NULL);
+
+    if (codec == NULL)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t pass;
+        for (pass = 0; pass < passes && result == 0; pass++)
+        {
+            size_t offset;
+            for (offset = 0; offset < stream_size && result == 0; offset += read_size)
+            {
+                size_t size = (stream_size - offset < read_size) ? stream_size - offset : read_size;
+                result = mqtt_codec_bytesReceived(codec, stream + offset, size);
+            }
+        }
+
+        mqtt_codec_destroy(codec);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result = 0;
+    int capture_count = argc - 1;
+    unsigned char** captures;
+    size_t* capture_sizes;
+
+    if (capture_count < 1)
+    {
+        (void)printf("usage: %s capture.bin...\r\n", argv[0]);
+        return MU_FAILURE;
+    }
+
+    captures = (unsigned char**)calloc((size_t)capture_count, sizeof(unsigned char*));
+    capture_sizes = (size_t*)calloc((size_t)capture_count, sizeof(size_t));
+    if (captures == NULL || capture_sizes == NULL)
+    {
+        (void)printf("Cannot allocate the capture list.\r\n");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        unsigned char* stream = NULL;
+        size_t stream_size = 0;
+        size_t stream_packets = 0;
+        size_t largest_capture = 0;
+        int i;
+
+        for (i = 0; i < capture_count && result == 0; i++)
+        {
+            if ((captures[i] = read_capture(argv[i + 1], &capture_sizes[i])) == NULL)
+            {
+                result = MU_FAILURE;
+            }
+            else if (capture_sizes[i] > largest_capture)
+            {
+                largest_capture = capture_sizes[i];
+            }
+        }
+
+        if (result == 0 && (stream = (unsigned char*)malloc(STREAM_SIZE + largest_capture)) == NULL)
+        {
+            (void)printf("Cannot allocate the stream.\r\n");
+            result = MU_FAILURE;
+        }
+
+        // repeat the captures in turn until the stream is STREAM_SIZE bytes long
+        for (i = 0; result == 0 && stream_size < STREAM_SIZE; i = (i + 1) % capture_count)
+        {
+            (void)memcpy(stream + stream_size, captures[i], capture_sizes[i]);
+            stream_size += capture_sizes[i];
+        }
+
+        if (result == 0)
+        {
+            // one pass in a single read gives the number of packets in the stream
+            packet_count = 0;
+            if (decode_stream(stream, stream_size, stream_size, 1) != 0 || packet_count == 0)
+            {
+                (void)printf("The captures do not decode as MQTT packets.\r\n");
+                result = MU_FAILURE;
+            }
+            stream_packets = packet_count;
+        }
+
+        if (result == 0)
+        {
+            size_t r;
+
+            (void)printf("%d captures, %lu byte stream of %lu packets, %d passes\r\n",
+                capture_count, (unsigned long)stream_size, (unsigned long)stream_packets, STREAM_PASSES);
+            (void)printf("  read size      MB/s   packets/s\r\n");
+
+            for (r = 0; r < sizeof(read_sizes) / sizeof(read_sizes[0]) && result == 0; r++)
+            {
+                clock_t start;
+                double seconds;
+
+                packet_count = 0;
+                start = clock();
+                if (decode_stream(stream, stream_size, read_sizes[r], STREAM_PASSES) != 0 ||
+                    packet_count != stream_packets * STREAM_PASSES)
+                {
+                    (void)printf("Decoding in %lu byte reads failed.\r\n", (unsigned long)read_sizes[r]);
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+                    if (seconds <= 0)
+                    {
+                        seconds = 1.0 / CLOCKS_PER_SEC;
+                    }
+
+                    (void)printf("  %9lu %9.1f %11.0f\r\n", (unsigned long)read_sizes[r],
+                        (double)stream_size * STREAM_PASSES / seconds / 1e6, (double)packet_count / seconds);
+                }
+            }
+        }
+
+        free(stream);
+        for (i = 0; i < capture_count; i++)
+        {
+            free(captures[i]);
+        }
+    }
+
+    free(captures);
+    free(capture_sizes);
+
+    return result;
+}
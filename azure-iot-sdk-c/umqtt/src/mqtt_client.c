@@ -403,6 +403,39 @@ static int sendPacketItem(MQTT_CLIENT* mqtt_client, const unsigned char* data, s
     return result;
 }
 
+// The payload is handed to the xio alongside the header rather than copied into the packet
+static int sendPublishPacket(MQTT_CLIENT* mqtt_client, BUFFER_HANDLE header, const uint8_t* payload, size_t length)
+{
+    XIO_SEND_BUFFER buffers[2];
+    buffers[0].buffer = BUFFER_u_char(header);
+    buffers[0].size = BUFFER_length(header);
+    buffers[1].buffer = payload;
+    buffers[1].size = length;
+
+    int result = xio_send_vectored(mqtt_client->xioHandle, buffers, length > 0 ? 2 : 1, sendComplete, mqtt_client);
+
+    if (result != 0)
+    {
+        LogError("Failure sending publish packet data");
+        result = MU_FAILURE;
+    }
+    else
+    {
+#ifdef ENABLE_RAW_TRACE
+        logOutgoingRawTrace(mqtt_client, (const uint8_t*)buffers[0].buffer, buffers[0].size);
+        logOutgoingRawTrace(mqtt_client, payload, length);
+#endif
+
+        if (tickcounter_get_current_ms(mqtt_client->packetTickCntr, &mqtt_client->packetSendTimeMs) != 0)
+        {
+            LogError("Failure getting current ms tickcounter");
+            result = MU_FAILURE;
+        }
+    }
+
+    return result;
+}
+
 static void onOpenComplete(void* context, IO_OPEN_RESULT open_result)
 {
     MQTT_CLIENT* mqtt_client = (MQTT_CLIENT*)context;
@@ -1157,11 +1190,11 @@ int mqtt_client_publish(MQTT_CLIENT_HANDLE handle, MQTT_MESSAGE_HANDLE msgHandle
             bool isRetained = mqttmessage_getIsRetained(msgHandle);
             uint16_t packetId = mqttmessage_getPacketId(msgHandle);
             const char* topicName = mqttmessage_getTopicName(msgHandle);
-            BUFFER_HANDLE publishPacket = mqtt_codec_publish(qos, isDuplicate, isRetained, packetId, topicName, payload->message, payload->length, trace_log);
+            BUFFER_HANDLE publishPacket = mqtt_codec_publishHeader(qos, isDuplicate, isRetained, packetId, topicName, payload->length, trace_log);
             if (publishPacket == NULL)
             {
                 /*Codes_SRS_MQTT_CLIENT_07_020: [If any failure is encountered then mqtt_client_unsubscribe shall return a non-zero value.]*/
-                LogError("Error: mqtt_codec_publish failed");
+                LogError("Error: mqtt_codec_publishHeader failed");
                 result = MU_FAILURE;
             }
             else
@@ -1169,8 +1202,7 @@ int mqtt_client_publish(MQTT_CLIENT_HANDLE handle, MQTT_MESSAGE_HANDLE msgHandle
                 mqtt_client->packetState = PUBLISH_TYPE;
 
                 /*Codes_SRS_MQTT_CLIENT_07_022: [On success mqtt_client_publish shall send the MQTT SUBCRIBE packet to the endpoint.]*/
-                size_t size = BUFFER_length(publishPacket);
-                if (sendPacketItem(mqtt_client, BUFFER_u_char(publishPacket), size) != 0)
+                if (sendPublishPacket(mqtt_client, publishPacket, payload->message, payload->length) != 0)
                 {
                     /*Codes_SRS_MQTT_CLIENT_07_020: [If any failure is encountered then mqtt_client_unsubscribe shall return a non-zero value.]*/
                     LogError("Error: mqtt_client_publish send failed");
@@ -333,10 +333,11 @@ static BUFFER_HANDLE constructPublishReply(CONTROL_PACKET_TYPE type, uint8_t fla
     return result;
 }
 
-static int constructFixedHeader(BUFFER_HANDLE ctrlPacket, CONTROL_PACKET_TYPE packetType, uint8_t flags)
+// payloadLen counts bytes that follow ctrlPacket on the wire but are not part of it
+static int constructFixedHeader(BUFFER_HANDLE ctrlPacket, CONTROL_PACKET_TYPE packetType, uint8_t flags, size_t payloadLen)
 {
     int result;
-    size_t packetLen = BUFFER_length(ctrlPacket);
+    size_t packetLen = BUFFER_length(ctrlPacket) + payloadLen;
     uint8_t remainSize[4] ={ 0 };
     size_t index = 0;
 
@@ -687,7 +688,7 @@ BUFFER_HANDLE mqtt_codec_connect(const MQTT_CLIENT_OPTIONS* mqttOptions, STRING_
                     {
                         (void)STRING_copy(trace_log, "CONNECT");
                     }
-                    if (constructFixedHeader(result, CONNECT_TYPE, 0) != 0)
+                    if (constructFixedHeader(result, CONNECT_TYPE, 0, 0) != 0)
                     {
                         /* Codes_SRS_MQTT_CODEC_07_010: [If any error is encountered then mqtt_codec_connect shall return NULL.] */
                         BUFFER_delete(result);
@@ -742,6 +743,25 @@ BUFFER_HANDLE mqtt_codec_disconnect()
     return result;
 }
 
+static uint8_t publishHeaderFlags(QOS_VALUE qosValue, bool duplicateMsg, bool serverRetain)
+{
+    uint8_t headerFlags = 0;
+    if (duplicateMsg) headerFlags |= PUBLISH_DUP_FLAG;
+    if (serverRetain) headerFlags |= PUBLISH_QOS_RETAIN;
+    if (qosValue != DELIVER_AT_MOST_ONCE)
+    {
+        if (qosValue == DELIVER_AT_LEAST_ONCE)
+        {
+            headerFlags |= PUBLISH_QOS_AT_LEAST_ONCE;
+        }
+        else
+        {
+            headerFlags |= PUBLISH_QOS_EXACTLY_ONCE;
+        }
+    }
+    return headerFlags;
+}
+
 BUFFER_HANDLE mqtt_codec_publish(QOS_VALUE qosValue, bool duplicateMsg, bool serverRetain, uint16_t packetId, const char* topicName, const uint8_t* msgBuffer, size_t buffLen, STRING_HANDLE trace_log)
 {
     BUFFER_HANDLE result;
@@ -763,20 +783,7 @@ BUFFER_HANDLE mqtt_codec_publish(QOS_VALUE qosValue, bool duplicateMsg, bool ser
         publishInfo.packetId = packetId;
         publishInfo.qualityOfServiceValue = qosValue;
 
-        uint8_t headerFlags = 0;
-        if (duplicateMsg) headerFlags |= PUBLISH_DUP_FLAG;
-        if (serverRetain) headerFlags |= PUBLISH_QOS_RETAIN;
-        if (qosValue != DELIVER_AT_MOST_ONCE)
-        {
-            if (qosValue == DELIVER_AT_LEAST_ONCE)
-            {
-                headerFlags |= PUBLISH_QOS_AT_LEAST_ONCE;
-            }
-            else
-            {
-                headerFlags |= PUBLISH_QOS_EXACTLY_ONCE;
-            }
-        }
+        uint8_t headerFlags = publishHeaderFlags(qosValue, duplicateMsg, serverRetain);
 
         /* Codes_SRS_MQTT_CODEC_07_007: [mqtt_codec_publish shall return a BUFFER_HANDLE that represents a MQTT PUBLISH message.] */
         result = BUFFER_new();
@@ -835,7 +842,7 @@ BUFFER_HANDLE mqtt_codec_publish(QOS_VALUE qosValue, bool duplicateMsg, bool ser
                     {
                         (void)STRING_copy(trace_log, "PUBLISH");
                     }
-                    if (constructFixedHeader(result, PUBLISH_TYPE, headerFlags) != 0)
+                    if (constructFixedHeader(result, PUBLISH_TYPE, headerFlags, 0) != 0)
                     {
                         /* Codes_SRS_MQTT_CODEC_07_006: [If any error is encountered then mqtt_codec_publish shall return NULL.] */
                         BUFFER_delete(result);
@@ -859,6 +866,62 @@ BUFFER_HANDLE mqtt_codec_publish(QOS_VALUE qosValue, bool duplicateMsg, bool ser
     return result;
 }
 
+BUFFER_HANDLE mqtt_codec_publishHeader(QOS_VALUE qosValue, bool duplicateMsg, bool serverRetain, uint16_t packetId, const char* topicName, size_t buffLen, STRING_HANDLE trace_log)
+{
+    BUFFER_HANDLE result;
+    if (topicName == NULL)
+    {
+        result = NULL;
+    }
+    else if (buffLen > MAX_SEND_SIZE)
+    {
+        result = NULL;
+    }
+    else
+    {
+        PUBLISH_HEADER_INFO publishInfo ={ 0 };
+        publishInfo.topicName = topicName;
+        publishInfo.packetId = packetId;
+        publishInfo.qualityOfServiceValue = qosValue;
+
+        uint8_t headerFlags = publishHeaderFlags(qosValue, duplicateMsg, serverRetain);
+
+        result = BUFFER_new();
+        if (result != NULL)
+        {
+            STRING_HANDLE varible_header_log = NULL;
+            if (trace_log != NULL)
+            {
+                varible_header_log = STRING_construct_sprintf(" | IS_DUP: %s | RETAIN: %d | QOS: %s", duplicateMsg ? TRUE_CONST : FALSE_CONST,
+                    serverRetain ? 1 : 0,
+                    retrieve_qos_value(publishInfo.qualityOfServiceValue) );
+            }
+
+            if (constructPublishVariableHeader(result, &publishInfo, varible_header_log) != 0 ||
+                constructFixedHeader(result, PUBLISH_TYPE, headerFlags, buffLen) != 0)
+            {
+                BUFFER_delete(result);
+                result = NULL;
+            }
+            else if (trace_log != NULL)
+            {
+                (void)STRING_copy(trace_log, "PUBLISH");
+                if (buffLen > 0)
+                {
+                    STRING_sprintf(varible_header_log, " | PAYLOAD_LEN: %lu", (unsigned long)buffLen);
+                }
+                (void)STRING_concat_with_STRING(trace_log, varible_header_log);
+            }
+
+            if (varible_header_log != NULL)
+            {
+                STRING_delete(varible_header_log);
+            }
+        }
+    }
+    return result;
+}
+
 BUFFER_HANDLE mqtt_codec_publishAck(uint16_t packetId)
 {
     /* Codes_SRS_MQTT_CODEC_07_013: [On success mqtt_codec_publishAck shall return a BUFFER_HANDLE representation of a MQTT PUBACK packet.] */
@@ -963,7 +1026,7 @@ BUFFER_HANDLE mqtt_codec_subscribe(uint16_t packetId, SUBSCRIBE_PAYLOAD* subscri
                     {
                         STRING_concat(trace_log, "SUBSCRIBE");
                     }
-                    if (constructFixedHeader(result, SUBSCRIBE_TYPE, SUBSCRIBE_FIXED_HEADER_FLAG) != 0)
+                    if (constructFixedHeader(result, SUBSCRIBE_TYPE, SUBSCRIBE_FIXED_HEADER_FLAG, 0) != 0)
                     {
                         /* Codes_SRS_MQTT_CODEC_07_025: [If any error is encountered then mqtt_codec_subscribe shall return NULL.] */
                         BUFFER_delete(result);
@@ -1027,7 +1090,7 @@ BUFFER_HANDLE mqtt_codec_unsubscribe(uint16_t packetId, const char** unsubscribe
                     {
                         (void)STRING_copy(trace_log, "UNSUBSCRIBE");
                     }
-                    if (constructFixedHeader(result, UNSUBSCRIBE_TYPE, UNSUBSCRIBE_FIXED_HEADER_FLAG) != 0)
+                    if (constructFixedHeader(result, UNSUBSCRIBE_TYPE, UNSUBSCRIBE_FIXED_HEADER_FLAG, 0) != 0)
                     {
                         /* Codes_SRS_MQTT_CODEC_07_029: [If any error is encountered then mqtt_codec_unsubscribe shall return NULL.] */
                         BUFFER_delete(result);
@@ -1165,11 +1228,26 @@ int mqtt_codec_bytesReceived(MQTTCODEC_HANDLE handle, const unsigned char* buffe
                     }
                     else
                     {
-                        // Increment the data
-                        dataBytes += codec_Data->bufferOffset++;
-                        *dataBytes = iterator;
-
                         size_t totalLen = BUFFER_length(codec_Data->headerData);
+                        size_t copyLen = size - index;
+                        if (copyLen == 1)
+                        {
+                            // a transport that hands over a byte at a time stores it as before, without a memcpy call
+                            dataBytes[codec_Data->bufferOffset++] = iterator;
+                        }
+                        else
+                        {
+                            // headerData was sized from the remaining length, copy as much of the rest of the packet as this buffer holds
+                            if (copyLen > totalLen - codec_Data->bufferOffset)
+                            {
+                                copyLen = totalLen - codec_Data->bufferOffset;
+                            }
+                            (void)memcpy(dataBytes + codec_Data->bufferOffset, buffer + index, copyLen);
+                            codec_Data->bufferOffset += copyLen;
+                            // the loop increment steps past the last byte copied
+                            index += copyLen - 1;
+                        }
+
                         if (codec_Data->bufferOffset >= totalLen)
                         {
                             /* Codes_SRS_MQTT_CODEC_07_034: [Upon a constructing a complete MQTT packet mqtt_codec_bytesReceived shall call the ON_PACKET_COMPLETE_CALLBACK function.] */
@@ -0,0 +1,286 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Counts the AMQP device DoWorks a poll of the shared transport costs, comparing TransportDoWorkHandler with the
+// DoWork-every-client walk it replaced. The IoT Hub client is a model of the AMQP transport, every client DoWork moves
+// that client's queued reported states to the transport and then services every registered device, as
+// IoTHubClientCore_LL_DoWork and IoTHubTransport_AMQP_Common_DoWork do.
+// Build with -DEDGE_DEVX_BENCHMARKS=ON -DAZURE_SHARED_TRANSPORT_SUPPORT=ON and run ./dx_azure_transport_bench [devices]
+
+#include "../src/dx_azure_connection.c"
+
+#include <stdio.h>
+#include <time.h>
+
+#define DEFAULT_DEVICES 500
+#define POLLS 200
+#define REPORTING_PERCENT 5
+
+typedef struct {
+    IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK connectionStatus;
+    void *connectionStatusContext;
+    size_t reportsQueued; // waiting in the client queue
+    size_t reportsSent;   // handed to the transport, acknowledged on its next DoWork
+    IOTHUB_CLIENT_REPORTED_STATE_CALLBACK reportedState;
+    void *reportedStateContext;
+    bool authenticated;
+} MODEL_CLIENT;
+
+static MODEL_CLIENT **registered;
+static size_t registeredCount;
+static unsigned long long deviceDoWorks;
+static volatile unsigned long long deviceWork;
+
+static void ModelTransportDoWork(void)
+{
+    for (size_t i = 0; i < registeredCount; i++) {
+        MODEL_CLIENT *client = registered[i];
+
+        deviceDoWorks++;
+        deviceWork += i;
+
+        if (!client->authenticated) {
+            client->authenticated = true;
+            client->connectionStatus(IOTHUB_CLIENT_CONNECTION_AUTHENTICATED, IOTHUB_CLIENT_CONNECTION_OK, client->connectionStatusContext);
+        }
+
+        while (client->reportsSent > 0) {
+            client->reportsSent--;
+            if (client->reportedState != NULL) {
+                client->reportedState(204, client->reportedStateContext);
+            }
+        }
+    }
+}
+
+int IoTHub_Init(void)
+{
+    return 0;
+}
+
+TRANSPORT_HANDLE IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol, const char *iotHubName, const char *iotHubSuffix)
+{
+    return (TRANSPORT_HANDLE)&registered;
+}
+
+void IoTHubTransport_Destroy(TRANSPORT_HANDLE transportHandle)
+{
+}
+
+TRANSPORT_LL_HANDLE IoTHubTransport_GetLLTransport(TRANSPORT_HANDLE transportHandle)
+{
+    return (TRANSPORT_LL_HANDLE)transportHandle;
+}
+
+const TRANSPORT_PROVIDER *AMQP_Protocol(void)
+{
+    return NULL;
+}
+
+IOTHUB_DEVICE_CLIENT_LL_HANDLE IoTHubDeviceClient_LL_CreateWithTransport(const IOTHUB_CLIENT_DEVICE_CONFIG *config)
+{
+    MODEL_CLIENT *client = (MODEL_CLIENT *)calloc(1, sizeof(MODEL_CLIENT));
+    MODEL_CLIENT **clients = (MODEL_CLIENT **)realloc(registered, (registeredCount + 1) * sizeof(MODEL_CLIENT *));
+
+    if (client == NULL || clients == NULL) {
+        free(client);
+        return NULL;
+    }
+
+    registered = clients;
+    registered[registeredCount++] = client;
+
+    return (IOTHUB_DEVICE_CLIENT_LL_HANDLE)client;
+}
+
+void IoTHubDeviceClient_LL_Destroy(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+    for (size_t i = 0; i < registeredCount; i++) {
+        if (registered[i] == (MODEL_CLIENT *)iotHubClientHandle) {
+            registered[i] = registered[--registeredCount];
+            break;
+        }
+    }
+
+    free(iotHubClientHandle);
+}
+
+void IoTHubDeviceClient_LL_DoWork(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+    MODEL_CLIENT *client = (MODEL_CLIENT *)iotHubClientHandle;
+
+    client->reportsSent += client->reportsQueued;
+    client->reportsQueued = 0;
+
+    ModelTransportDoWork();
+}
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_SetOption(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle, const char *optionName, const void *value)
+{
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_SetConnectionStatusCallback(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle,
+                                                                      IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK connectionStatusCallback, void *userContextCallback)
+{
+    ((MODEL_CLIENT *)iotHubClientHandle)->connectionStatus = connectionStatusCallback;
+    ((MODEL_CLIENT *)iotHubClientHandle)->connectionStatusContext = userContextCallback;
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_SetMessageCallback(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle,
+                                                             IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void *userContextCallback)
+{
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_SetDeviceTwinCallback(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle,
+                                                                IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK deviceTwinCallback, void *userContextCallback)
+{
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_SetDeviceMethodCallback(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle,
+                                                                  IOTHUB_CLIENT_DEVICE_METHOD_CALLBACK_ASYNC deviceMethodCallback, void *userContextCallback)
+{
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_SendReportedState(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle, const unsigned char *reportedState,
+                                                            size_t size, IOTHUB_CLIENT_REPORTED_STATE_CALLBACK reportedStateCallback,
+                                                            void *userContextCallback)
+{
+    MODEL_CLIENT *client = (MODEL_CLIENT *)iotHubClientHandle;
+
+    client->reportsQueued++;
+    client->reportedState = reportedStateCallback;
+    client->reportedStateContext = userContextCallback;
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_SendEventAsync(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle,
+                                                         IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void *userContextCallback)
+{
+    return IOTHUB_CLIENT_OK;
+}
+
+void IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+}
+
+IOTHUB_MESSAGE_HANDLE dx_azureCreateMessage(const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties,
+                                            size_t messagePropertyCount, DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties)
+{
+    return NULL;
+}
+
+bool dx_isStringNullOrEmpty(const char *string)
+{
+    return string == NULL || *string == '\0';
+}
+
+void dx_Log_Debug(char *fmt, ...)
+{
+}
+
+/// <summary>
+/// The walk TransportDoWorkHandler used to make, a DoWork for every client
+/// </summary>
+static void EveryClientDoWork(DX_AZURE_TRANSPORT *transport)
+{
+    for (DX_AZURE_CONNECTION *connection = transport->connections; connection != NULL; connection = connection->next) {
+        connection->reportQueued = false;
+        IoTHubDeviceClient_LL_DoWork(connection->clientHandle);
+    }
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/// <summary>
+/// Runs POLLS polls, the connections in reporting report their state before each poll. Returns device DoWorks per poll.
+/// </summary>
+static double run_polls(DX_AZURE_TRANSPORT *transport, DX_AZURE_CONNECTION **connections, int devices, int reporting, bool everyClient, double *us)
+{
+    static const unsigned char state[] = "{\"status\":\"ok\"}";
+    double start;
+
+    deviceDoWorks = 0;
+    start = now_seconds();
+
+    for (int poll = 0; poll < POLLS; poll++) {
+        for (int i = 0; i < reporting; i++) {
+            dx_azureConnectionReportState(connections[(poll * reporting + i) % devices], state, sizeof(state) - 1);
+        }
+
+        if (everyClient) {
+            EveryClientDoWork(transport);
+        } else {
+            TransportDoWorkHandler(&transport->doWorkTimer);
+        }
+    }
+
+    *us = (now_seconds() - start) / POLLS * 1e6;
+    return (double)deviceDoWorks / POLLS;
+}
+
+int main(int argc, char *argv[])
+{
+    int devices = argc > 1 ? atoi(argv[1]) : DEFAULT_DEVICES;
+    int reporting = devices * REPORTING_PERCENT / 100;
+    DX_AZURE_CONNECTION **connections;
+    DX_AZURE_TRANSPORT *transport;
+    char deviceId[32];
+    double us;
+
+    if (devices <= 0 || (connections = (DX_AZURE_CONNECTION **)calloc((size_t)devices, sizeof(DX_AZURE_CONNECTION *))) == NULL) {
+        printf("usage: %s [devices]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    transport = dx_azureTransportCreate("bench", "azure-devices.net");
+
+    for (int i = 0; i < devices; i++) {
+        DX_AZURE_DEVICE_CONFIG config = {.deviceId = deviceId, .deviceKey = "key"};
+
+        snprintf(deviceId, sizeof(deviceId), "device%d", i);
+        if ((connections[i] = dx_azureConnectionCreate(transport, &config)) == NULL) {
+            printf("failed to create device %d\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // authenticate every device
+    TransportDoWorkHandler(&transport->doWorkTimer);
+
+    printf("%d devices, %d polls, %d devices report their state before each poll when reporting\n", devices, POLLS, reporting);
+    printf("                                    device DoWorks/poll   us/poll\n");
+
+    for (int i = 0; i < 4; i++) {
+        bool everyClient = (i & 1) == 0;
+        double doWorks = run_polls(transport, connections, devices, i < 2 ? 0 : reporting, everyClient, &us);
+
+        printf("  %-24s %-9s %12.0f %9.1f\n", everyClient ? "every client" : "TransportDoWorkHandler", i < 2 ? "idle" : "reporting", doWorks, us);
+    }
+
+    // the last poll hands every queued reported state to the transport
+    TransportDoWorkHandler(&transport->doWorkTimer);
+
+    for (size_t i = 0; i < registeredCount; i++) {
+        if (registered[i]->reportsQueued != 0 || registered[i]->reportsSent != 0) {
+            printf("client %zu has reported states that were never sent\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    dx_azureTransportDestroy(transport);
+    uv_run(uv_default_loop(), UV_RUN_NOWAIT);
+    free(connections);
+    free(registered);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+// Compares dx_jsonSerialize and dx_jsonSchemaSerialize with the parson based serializer they replaced, and checks that
+// every number written by dx_jsonWriteDouble reads back as the same double.
+// Build with -DEDGE_DEVX_BENCHMARKS=ON and run ./dx_json_serializer_bench [messages]
+
+#include "dx_json_serializer.h"
+#include "dx_utilities.h"
+#include "parson.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_MESSAGES 200000
+#define ROUND_TRIP_VALUES 2000000
+
+/// <summary>
+/// The parson based dx_jsonSerialize this library used to ship
+/// </summary>
+static bool parson_jsonSerialize(char *buffer, size_t buffer_size, int key_value_pair_count, ...)
+{
+    JSON_Value *root_value = json_value_init_object();
+    JSON_Object *root_object = json_value_get_object(root_value);
+
+    char *json_string = NULL;
+    char *key = NULL;
+    bool result = false;
+
+    va_list valist;
+    va_start(valist, key_value_pair_count);
+
+    while (key_value_pair_count--) {
+        DX_JSON_TYPE type = va_arg(valist, int);
+        key = va_arg(valist, char *);
+
+        switch (type) {
+        case DX_JSON_INT:
+            json_object_set_number(root_object, key, va_arg(valist, int));
+            break;
+
+            // floats are cast to doubles for valists
+        case DX_JSON_FLOAT:
+        case DX_JSON_DOUBLE:
+            json_object_set_number(root_object, key, va_arg(valist, double));
+            break;
+
+        case DX_JSON_STRING:
+            json_object_set_string(root_object, key, va_arg(valist, char *));
+            break;
+
+        case DX_JSON_BOOL:
+            json_object_set_boolean(root_object, key, va_arg(valist, int));
+            break;
+
+        default:
+            break;
+        }
+    }
+    va_end(valist);
+
+    json_string = json_serialize_to_string(root_value);
+
+    if (strlen(json_string) < buffer_size) {
+        DX_SAFE_STRING_COPY(buffer, json_string, buffer_size);
+        result = true;
+    }
+
+    json_free_serialized_string(json_string);
+    json_value_free(root_value);
+
+    return result;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t random_state = 88172645463325252ull;
+
+static uint64_t random_next(void)
+{
+    // xorshift64
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+/// <summary>
+/// Raw bit patterns, float converted readings, short decimals and tiny floats, returns the number that did not read back
+/// </summary>
+static long check_round_trip(long count)
+{
+    char buffer[64];
+    DX_JSON_WRITER writer;
+    long failures = 0;
+
+    for (long i = 0; i < count; i++) {
+        uint64_t bits = random_next();
+        double value;
+
+        switch (i % 4) {
+        case 0:
+            memcpy(&value, &bits, sizeof(value));
+            if (!isfinite(value)) {
+                continue;
+            }
+            break;
+        case 1:
+            value = (float)((double)(bits % 2000000) / 100.0 - 10000);
+            break;
+        case 2:
+            value = (double)(long long)(bits % 100000) / 1000.0;
+            break;
+        default:
+            value = (float)((bits % 1000000) * 1e-9);
+            break;
+        }
+
+        dx_jsonWriterInit(&writer, buffer, sizeof(buffer));
+        dx_jsonWriteDouble(&writer, value);
+
+        if (writer.overflow || strtod(buffer, NULL) != value) {
+            if (failures < 5) {
+                printf("  %.17g written as %s\n", value, buffer);
+            }
+            failures++;
+        }
+    }
+
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    int messages = argc > 1 ? atoi(argv[1]) : DEFAULT_MESSAGES;
+    char buffer[256];
+    double start, parson_ns, serialize_ns, schema_ns;
+
+    DX_JSON_FIELD fields[] = {
+        {DX_JSON_FLOAT, "temperature", 2},
+        {DX_JSON_DOUBLE, "pressure", 2},
+        {DX_JSON_INT, "humidity", 0},
+        {DX_JSON_STRING, "status", 0},
+    };
+    DX_JSON_SCHEMA schema = {.fields = fields, .field_count = sizeof(fields) / sizeof(fields[0])};
+
+    if (messages <= 0 || !dx_jsonSchemaInit(&schema)) {
+        printf("usage: %s [messages]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    long failures = check_round_trip(ROUND_TRIP_VALUES);
+    printf("round trip: %d values, %ld did not read back\n", ROUND_TRIP_VALUES, failures);
+
+    parson_jsonSerialize(buffer, sizeof(buffer), 4, DX_JSON_FLOAT, "temperature", (float)23.4, DX_JSON_DOUBLE, "pressure", 1013.25,
+                         DX_JSON_INT, "humidity", 45, DX_JSON_FLOAT, "tiny", (float)1e-7);
+    printf("parson:           %s\n", buffer);
+    dx_jsonSerialize(buffer, sizeof(buffer), 4, DX_JSON_FLOAT, "temperature", (float)23.4, DX_JSON_DOUBLE, "pressure", 1013.25,
+                     DX_JSON_INT, "humidity", 45, DX_JSON_FLOAT, "tiny", (float)1e-7);
+    printf("dx_jsonSerialize: %s\n", buffer);
+
+    start = now_seconds();
+    for (int i = 0; i < messages; i++) {
+        parson_jsonSerialize(buffer, sizeof(buffer), 4, DX_JSON_FLOAT, "temperature", (float)(20 + i % 100 * 0.1), DX_JSON_DOUBLE,
+                             "pressure", 1000 + i % 500 * 0.25, DX_JSON_INT, "humidity", i % 100, DX_JSON_STRING, "status", "cooling");
+    }
+    parson_ns = (now_seconds() - start) / messages * 1e9;
+
+    start = now_seconds();
+    for (int i = 0; i < messages; i++) {
+        dx_jsonSerialize(buffer, sizeof(buffer), 4, DX_JSON_FLOAT, "temperature", (float)(20 + i % 100 * 0.1), DX_JSON_DOUBLE, "pressure",
+                         1000 + i % 500 * 0.25, DX_JSON_INT, "humidity", i % 100, DX_JSON_STRING, "status", "cooling");
+    }
+    serialize_ns = (now_seconds() - start) / messages * 1e9;
+
+    start = now_seconds();
+    for (int i = 0; i < messages; i++) {
+        dx_jsonSchemaSerialize(&schema, buffer, sizeof(buffer), (float)(20 + i % 100 * 0.1), 1000 + i % 500 * 0.25, i % 100, "cooling");
+    }
+    schema_ns = (now_seconds() - start) / messages * 1e9;
+
+    printf("%d messages\n", messages);
+    printf("  parson                            %8.0f ns/message\n", parson_ns);
+    printf("  dx_jsonSerialize                  %8.0f ns/message\n", serialize_ns);
+    printf("  dx_jsonSchemaSerialize (2 places) %8.0f ns/message\n", schema_ns);
+
+    dx_jsonSchemaFree(&schema);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
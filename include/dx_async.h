@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <uv.h>
 
 #define DX_ASYNC_HANDLER(name, handle) void name(uv_async_t *handle) {
@@ -15,8 +17,19 @@ typedef struct {
   char *name;
   uv_async_t async;
   void (*handler)(uv_async_t *handle);
+  // Optional. When non zero sends are queued in a bounded lock free ring of this many items (rounded up to a power of
+  // two) instead of overwriting async.data, and the handler is called once per item with handle->data set to the item.
+  size_t queue_size;
+  void *__queue;
 } DX_ASYNC_BINDING;
 
 void dx_asyncInit(DX_ASYNC_BINDING *async);
-void dx_asyncSend(DX_ASYNC_BINDING *binding, void *data);
+
+/// <summary>
+/// Send data to the event loop, safe to call from any thread. For a queued binding returns false if the queue is full.
+/// </summary>
+/// <param name="binding"></param>
+/// <param name="data"></param>
+/// <returns></returns>
+bool dx_asyncSend(DX_ASYNC_BINDING *binding, void *data);
 void dx_asyncSetInit(DX_ASYNC_BINDING *asyncSet[], size_t asyncCount);
\ No newline at end of file
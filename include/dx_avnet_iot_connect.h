@@ -24,7 +24,9 @@ SOFTWARE.
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "dx_config.h"
+#include "dx_json_serializer.h"
 
 #define DX_AVNET_IOT_CONNECT_GUID_LEN 36
 #define DX_AVNET_IOT_CONNECT_SID_LEN 64
@@ -61,19 +63,29 @@ typedef enum
     AVT_RESPONSE_CODE_UID_ALREADY_EXISTS = 8
 } AVT_IOTC_221_RESPONSE_CODES;
 
-// Linked list node definition
+// Gateway child device. Children are held in a contiguous array indexed by id, so a pointer to a child is only valid
+// until the child list next changes (a 204, 221 or 222 response), look children up again with dx_avnetFindChild.
 typedef struct node {
-	struct node* next;
-	struct node* prev;
-	char tg[DX_AVNET_IOT_CONNECT_GW_FIELD_LEN];
-	char id[DX_AVNET_IOT_CONNECT_GW_FIELD_LEN];
+	const char* tg;     // interned, children with the same tag share one copy
+	char* id;
+	uint32_t __hash;
+	bool __present;     // set while a 204 child list is being applied
 } gw_child_list_node_t;
 
+/// <summary>
+/// An IoTConnect telemetry message being written in place, see dx_avnetEnvelopeBegin
+/// </summary>
+typedef struct
+{
+    DX_JSON_WRITER writer;
+    size_t recordCount;
+} DX_AVNET_ENVELOPE;
+
 /// <summary>
 /// Takes properly formatted JSON telemetry data and wraps it with ToTConnect
 /// metaData.  Returns false if the application has not received the IoTConnect hello
 /// response, if the passed in buffer is too small for the modified JSON document, or
-/// if the passed in JSON is malformed.  If childDevice is passed in is non-NULL, the payload
+/// if the passed in JSON is not an object.  If childDevice is passed in is non-NULL, the payload
 /// will be formatted for a gateway child device using the id and tag values set in the
 /// gw_child_list_note_t structure.
 /// </summary>
@@ -98,6 +110,45 @@ bool dx_avnetJsonSerializePayload(const char *originalJsonMessage, char *modifie
 /// <returns></returns>
 bool dx_avnetJsonSerialize(char * jsonMessageBuffer, size_t bufferSize, gw_child_list_node_t* childDevice, int key_value_pair_count, ...);
 
+/// <summary>
+/// Starts an IoTConnect telemetry message in buffer, writing the sid, dtg and mt header. Add one or more device or child
+/// device records then call dx_avnetEnvelopeEnd. Nothing is allocated or parsed, so a gateway can publish for many
+/// children in one message.
+/// </summary>
+/// <param name="envelope"></param>
+/// <param name="buffer"></param>
+/// <param name="bufferSize"></param>
+/// <returns>false if the header did not fit in the buffer</returns>
+bool dx_avnetEnvelopeBegin(DX_AVNET_ENVELOPE *envelope, char *buffer, size_t bufferSize);
+
+/// <summary>
+/// Appends a record holding a JSON object of telemetry, produced by dx_jsonSerialize for example. The telemetry is
+/// copied as is, it is only checked to be an object. If childDevice is NULL the record is for this device.
+/// </summary>
+/// <param name="envelope"></param>
+/// <param name="childDevice"></param>
+/// <param name="telemetryJson"></param>
+/// <returns>false if the telemetry is not an object or the buffer is full</returns>
+bool dx_avnetEnvelopeAddRecord(DX_AVNET_ENVELOPE *envelope, gw_child_list_node_t *childDevice, const char *telemetryJson);
+
+/// <summary>
+/// Appends a record built from (type, key, value) triples, written directly into the envelope buffer.
+/// If childDevice is NULL the record is for this device.
+/// </summary>
+/// <param name="envelope"></param>
+/// <param name="childDevice"></param>
+/// <param name="key_value_pair_count"></param>
+/// <param name="(type, key, value) triples"></parm>
+/// <returns>false if a type is not recognised or the buffer is full</returns>
+bool dx_avnetEnvelopeAddFields(DX_AVNET_ENVELOPE *envelope, gw_child_list_node_t *childDevice, int key_value_pair_count, ...);
+
+/// <summary>
+/// Closes the record list, the buffer then holds the complete message
+/// </summary>
+/// <param name="envelope"></param>
+/// <returns>false if the message did not fit in the buffer</returns>
+bool dx_avnetEnvelopeEnd(DX_AVNET_ENVELOPE *envelope);
+
 /// <summary>
 /// Initializes the IoTConnect timer.  This routine should be called on application init
 /// </summary>
@@ -0,0 +1,90 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#pragma once
+
+#include "dx_azure_iot.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Many device identities over one IoT Hub connection. Each DX_AZURE_CONNECTION is a device registered on a shared
+// DX_AZURE_TRANSPORT, the devices share a single AMQP connection and TLS session and each has its own twin, direct
+// method and cloud to device routing. Requires AZURE_SHARED_TRANSPORT_SUPPORT in CMake. The single device dx_azure* API
+// is unchanged and can be used alongside.
+
+typedef struct _azureTransport DX_AZURE_TRANSPORT;
+typedef struct _azureConnection DX_AZURE_CONNECTION;
+
+typedef struct {
+    const char *deviceId;
+    const char *deviceKey; // symmetric key, x509 is not supported on a shared transport
+    void (*connectionChanged)(DX_AZURE_CONNECTION *connection, bool connected, void *context);
+    IOTHUBMESSAGE_DISPOSITION_RESULT (*messageReceived)(DX_AZURE_CONNECTION *connection, IOTHUB_MESSAGE_HANDLE message, void *context);
+    void (*deviceTwinChanged)(DX_AZURE_CONNECTION *connection, DEVICE_TWIN_UPDATE_STATE updateState, const unsigned char *payload,
+                              size_t payloadSize, void *context);
+    // returns the method status, *response is a heap allocated JSON value freed by the SDK. Methods are answered 404 if not set
+    int (*directMethod)(DX_AZURE_CONNECTION *connection, const char *methodName, const unsigned char *payload, size_t payloadSize,
+                        unsigned char **response, size_t *responseLength, void *context);
+    void *context;
+} DX_AZURE_DEVICE_CONFIG;
+
+/// <summary>
+/// Open a shared connection to an IoT Hub, for example "contoso-hub" and "azure-devices.net". The connection is driven
+/// by the event loop and is made once the first device is added.
+/// </summary>
+/// <param name="iotHubName"></param>
+/// <param name="iotHubSuffix"></param>
+/// <returns>NULL if the transport could not be created</returns>
+DX_AZURE_TRANSPORT *dx_azureTransportCreate(const char *iotHubName, const char *iotHubSuffix);
+
+/// <summary>
+/// Remove any remaining devices and close the shared connection
+/// </summary>
+/// <param name="transport"></param>
+void dx_azureTransportDestroy(DX_AZURE_TRANSPORT *transport);
+
+/// <summary>
+/// Register a device on the shared transport. The config strings are copied.
+/// </summary>
+/// <param name="transport"></param>
+/// <param name="config"></param>
+/// <returns>NULL if the device could not be registered</returns>
+DX_AZURE_CONNECTION *dx_azureConnectionCreate(DX_AZURE_TRANSPORT *transport, const DX_AZURE_DEVICE_CONFIG *config);
+
+/// <summary>
+/// Unregister a device, messages not yet sent are discarded
+/// </summary>
+/// <param name="connection"></param>
+void dx_azureConnectionDestroy(DX_AZURE_CONNECTION *connection);
+
+/// <summary>
+/// Check if the device has been authenticated by IoT Hub
+/// </summary>
+/// <param name="connection"></param>
+/// <returns></returns>
+bool dx_azureConnectionIsConnected(DX_AZURE_CONNECTION *connection);
+
+/// <summary>
+/// Send a device to cloud message for this device. Application and content properties can be NULL if not required.
+/// publishComplete (optional) is called with delivered true once IoT Hub acknowledges the message.
+/// </summary>
+/// <returns>false if not connected or the message could not be queued, in which case publishComplete is not called</returns>
+bool dx_azureConnectionPublish(DX_AZURE_CONNECTION *connection, const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties,
+                               size_t messagePropertyCount, DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties,
+                               DX_PUBLISH_COMPLETE_HANDLER publishComplete, void *context);
+
+/// <summary>
+/// Send a device twin reported properties patch for this device
+/// </summary>
+/// <param name="connection"></param>
+/// <param name="reportedState">JSON object</param>
+/// <param name="reportedStateLength"></param>
+/// <returns></returns>
+bool dx_azureConnectionReportState(DX_AZURE_CONNECTION *connection, const unsigned char *reportedState, size_t reportedStateLength);
+
+/// <summary>
+/// The device id the connection was created with
+/// </summary>
+/// <param name="connection"></param>
+/// <returns></returns>
+const char *dx_azureConnectionDeviceId(DX_AZURE_CONNECTION *connection);
@@ -20,6 +20,11 @@
 #define IOT_HUB_POLL_TIME_NANOSECONDS 100000000
 #endif
 
+// DoWork period for keepalive and retry processing when the IoT Hub socket is watched by the event loop
+#ifndef IOT_HUB_HOUSEKEEPING_TIME_SECONDS
+#define IOT_HUB_HOUSEKEEPING_TIME_SECONDS 1
+#endif
+
 typedef struct DX_MESSAGE_PROPERTY {
     const char *key;
     const char *value;
@@ -30,6 +35,17 @@ typedef struct DX_MESSAGE_CONTENT_PROPERTIES {
     const char *contentType;
 } DX_MESSAGE_CONTENT_PROPERTIES;
 
+typedef void (*DX_PUBLISH_COMPLETE_HANDLER)(bool delivered, void *context);
+
+typedef struct DX_PUBLISH_ITEM {
+    const void *message;
+    size_t messageLength;
+    DX_MESSAGE_PROPERTY **messageProperties;
+    size_t messagePropertyCount;
+    DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties;
+    void *context;
+} DX_PUBLISH_ITEM;
+
 /// <summary>
 /// Check if there is a network connection and an authenticated connection to Azure IoT Hub/Central
 /// </summary>
@@ -40,6 +56,8 @@ bool dx_isAzureConnected(void);
 /// <summary>
 /// Send message to Azure IoT Hub/Central with application and content properties.
 /// Application and content properties can be NULL if not required.
+/// Returns false if not connected or the publish window is closed, see dx_azureSetPublishWindow.
+/// When not connected and the telemetry spool is open the message is stored for replay, see dx_telemetrySpoolOpen.
 /// </summary>
 /// <param name="msg"></param>
 /// <param name="messageProperties"></param>
@@ -49,6 +67,66 @@ bool dx_isAzureConnected(void);
 bool dx_azurePublish(const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties, size_t messagePropertyCount,
                      DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties);
 
+/// <summary>
+/// Create an IoT Hub message with application and content properties, which can be NULL if not required.
+/// The caller destroys the message with IoTHubMessage_Destroy.
+/// </summary>
+/// <returns>NULL if the message could not be created</returns>
+IOTHUB_MESSAGE_HANDLE dx_azureCreateMessage(const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties, size_t messagePropertyCount,
+                                            DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties);
+
+/// <summary>
+/// Stage a message for Azure IoT Hub/Central without blocking on the network. The message is copied, so the caller's buffer can be reused on return.
+/// All messages staged before the next event loop iteration are handed to the IoT Hub client together and flushed with a single DoWork.
+/// publishComplete (optional) is called with delivered true once IoT Hub acknowledges the message, or false if it could not be sent.
+/// Returns false if the message could not be staged, in which case publishComplete is not called.
+/// </summary>
+/// <param name="message"></param>
+/// <param name="messageLength"></param>
+/// <param name="messageProperties"></param>
+/// <param name="messagePropertyCount"></param>
+/// <param name="messageContentProperties"></param>
+/// <param name="publishComplete"></param>
+/// <param name="context"></param>
+/// <returns></returns>
+bool dx_azurePublishStaged(const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties, size_t messagePropertyCount,
+                           DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties, DX_PUBLISH_COMPLETE_HANDLER publishComplete, void *context);
+
+/// <summary>
+/// Bound the number of outstanding messages (staged or sent but not yet acknowledged by IoT Hub).
+/// When the outstanding count reaches highWatermark the publish window closes and dx_azurePublish, dx_azurePublishStaged
+/// and dx_azurePublishBatch reject new messages. The window reopens when the count drains to lowWatermark.
+/// publishWindowCallback (optional) is called each time the window opens or closes. A highWatermark of 0 disables the window (default).
+/// </summary>
+/// <param name="highWatermark"></param>
+/// <param name="lowWatermark"></param>
+/// <param name="publishWindowCallback"></param>
+void dx_azureSetPublishWindow(size_t highWatermark, size_t lowWatermark, void (*publishWindowCallback)(bool open));
+
+/// <summary>
+/// Number of messages staged or sent to IoT Hub and not yet acknowledged
+/// </summary>
+/// <param name=""></param>
+/// <returns></returns>
+size_t dx_azureGetOutstandingCount(void);
+
+/// <summary>
+/// Check if the publish window is open and new messages will be accepted
+/// </summary>
+/// <param name=""></param>
+/// <returns></returns>
+bool dx_azureIsPublishWindowOpen(void);
+
+/// <summary>
+/// Stage a batch of messages, see dx_azurePublishStaged. publishComplete is called once per message with the item's context.
+/// Returns the number of items staged, staging stops at the first failure.
+/// </summary>
+/// <param name="items"></param>
+/// <param name="itemCount"></param>
+/// <param name="publishComplete"></param>
+/// <returns></returns>
+size_t dx_azurePublishBatch(DX_PUBLISH_ITEM *items, size_t itemCount, DX_PUBLISH_COMPLETE_HANDLER publishComplete);
+
 /// <summary>
 /// Initialise Azure IoT Hub/Connection connection, passing in network interface for connecting testing and IoT Plug and Play model id.
 /// Cloud to device messages is also enabled. For information on Plug and Play see
@@ -59,6 +137,15 @@ bool dx_azurePublish(const void *message, size_t messageLength, DX_MESSAGE_PROPE
 /// <param name="plugAndPlayModelId"></param>
 void dx_azureConnect(DX_USER_CONFIG *userConfig, const char *networkInterface, const char *plugAndPlayModelId);
 
+/// <summary>
+/// Run the Azure IoT client from socket events rather than polling every IOT_HUB_POLL_TIME_NANOSECONDS.
+/// The IoT Hub socket is registered with the event loop and DoWork runs when the socket is readable, when queued data can be written,
+/// and every IOT_HUB_HOUSEKEEPING_TIME_SECONDS for keepalive and retry processing.
+/// Falls back to polling if the transport does not support socket watching. Takes effect when the next IoT Hub client is created.
+/// </summary>
+/// <param name="enabled"></param>
+void dx_azureSetEventDrivenDoWork(bool enabled);
+
 /// <summary>
 /// Stop Cloud to device messaging. Device twins and direct method messages will not be recieved or processed.
 /// </summary>
@@ -64,6 +64,19 @@ bool dx_deviceTwinAckDesiredValue(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, voi
 /// <returns></returns>
 bool dx_deviceTwinReportValue(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, void *state);
 
+/// <summary>
+/// Merge reported values into a single reported properties patch per flush interval instead of one update per report.
+/// Both dx_deviceTwinReportValue and dx_deviceTwinAckDesiredValue are batched and the last value reported for a property
+/// wins. The patch is sent early once it reaches maxPatchBytes (0 for no limit). reportCompleteHandler (optional) is called
+/// for each property in the patch once IoT Hub accepts or rejects it. A flushIntervalMs of 0 flushes any pending values
+/// and restores immediate reporting.
+/// </summary>
+/// <param name="flushIntervalMs"></param>
+/// <param name="maxPatchBytes"></param>
+/// <param name="reportCompleteHandler"></param>
+void dx_deviceTwinSetReportBatching(unsigned int flushIntervalMs, size_t maxPatchBytes,
+                                    void (*reportCompleteHandler)(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, bool delivered));
+
 /// <summary>
 /// Close all device twins, deallocate backing storage for each twin, and stop inbound and outbound device twin updates.
 /// </summary>
@@ -4,6 +4,13 @@
 #pragma once
 
 #include "parson.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Size of the buffer returned by dx_directMethodResponseBuffer
+#ifndef DX_DIRECT_METHOD_RESPONSE_BUFFER_SIZE
+#define DX_DIRECT_METHOD_RESPONSE_BUFFER_SIZE 512
+#endif
 
 #define DX_DIRECT_METHOD_HANDLER(name, json, directMethodBinding, responseMsg)                                         \
     DX_DIRECT_METHOD_RESPONSE_CODE name(JSON_Value *json, DX_DIRECT_METHOD_BINDING *directMethodBinding, char **responseMsg) \
@@ -28,7 +35,31 @@ typedef struct _directMethodBinding
     DX_DIRECT_METHOD_RESPONSE_CODE(*handler)
     (JSON_Value *json, struct _directMethodBinding *peripheral, char **responseMsg);
     void *context;
+    bool lazyPayload; // the handler is passed a NULL json value and calls dx_directMethodPayloadJson if it needs the payload
 } DX_DIRECT_METHOD_BINDING;
 
+/// <summary>
+/// Parse the payload of the direct method being handled. Only valid from a handler, the value is freed when the handler returns.
+/// Returns NULL if the payload is not valid JSON.
+/// </summary>
+/// <param name=""></param>
+/// <returns></returns>
+JSON_Value *dx_directMethodPayloadJson(void);
+
+/// <summary>
+/// Raw payload of the direct method being handled, not null terminated. Only valid from a handler.
+/// </summary>
+/// <param name="payloadSize"></param>
+/// <returns></returns>
+const unsigned char *dx_directMethodPayload(size_t *payloadSize);
+
+/// <summary>
+/// Preallocated buffer of DX_DIRECT_METHOD_RESPONSE_BUFFER_SIZE bytes a handler can format its response message into and
+/// return in responseMsg instead of a heap allocated string. Only valid from a handler.
+/// </summary>
+/// <param name=""></param>
+/// <returns></returns>
+char *dx_directMethodResponseBuffer(void);
+
 void dx_directMethodUnsubscribe(void);
 void dx_directMethodSubscribe(DX_DIRECT_METHOD_BINDING *directMethods[], size_t directMethodCount);
\ No newline at end of file
@@ -23,6 +23,10 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#define DX_GPIO_GROUP_MAX_LINES 32
 
 typedef enum
 {
@@ -44,7 +48,7 @@ typedef enum
     DX_GPIO_DETECT_BOTH
 } DX_GPIO_INPUT_DETECT;
 
-typedef struct
+typedef struct _gpioBinding
 {
     void *__line_handle; // points to object of type struct gpiod_line
     int chip_number;
@@ -53,8 +57,27 @@ typedef struct
     DX_GPIO_DIRECTION direction;
     DX_GPIO_INPUT_DETECT detect;
     DX_GPIO_STATE initial_state;
+    // Optional for inputs, when set the line is opened for edge events selected by detect (LOW falling, HIGH rising) and the
+    // handler is called from the event loop for each edge with the kernel timestamp of the edge
+    void (*edge_handler)(struct _gpioBinding *gpio_binding, DX_GPIO_STATE state, const struct timespec *timestamp);
+    unsigned int debounce_ms; // edges within debounce_ms of the last reported edge are dropped
+    void *context;
+    void *__edge_watch; // event loop registration for edge events
 } DX_GPIO_BINDING;
 
+// A set of lines on one chip requested together and read or written as a bitmask in a single call.
+// Bit n of the mask is line_numbers[n].
+typedef struct
+{
+    void *__bulk_handle; // points to object of type struct gpiod_line_bulk
+    int chip_number;
+    const unsigned int *line_numbers;
+    size_t line_count; // up to DX_GPIO_GROUP_MAX_LINES
+    char *name;
+    DX_GPIO_DIRECTION direction;
+    uint32_t initial_state; // output groups only
+} DX_GPIO_GROUP;
+
 bool dx_gpioClose(DX_GPIO_BINDING *gpio_binding);
 bool dx_gpioOff(DX_GPIO_BINDING *gpio_binding);
 bool dx_gpioOn(DX_GPIO_BINDING *gpio_binding);
@@ -63,3 +86,8 @@ int dx_gpioStateGet(DX_GPIO_BINDING *gpio_binding);
 bool dx_gpioStateSet(DX_GPIO_BINDING *gpio_binding, bool state);
 void dx_gpioSetClose(DX_GPIO_BINDING **gpio_bindings, size_t gpio_bindings_count);
 void dx_gpioSetOpen(DX_GPIO_BINDING **gpio_bindings, size_t gpio_bindings_count);
+
+bool dx_gpioGroupClose(DX_GPIO_GROUP *gpio_group);
+bool dx_gpioGroupOpen(DX_GPIO_GROUP *gpio_group);
+bool dx_gpioGroupRead(DX_GPIO_GROUP *gpio_group, uint32_t *state);
+bool dx_gpioGroupWrite(DX_GPIO_GROUP *gpio_group, uint32_t state);
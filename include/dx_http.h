@@ -0,0 +1,53 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct curl_slist;
+
+// Idle connections kept open across requests by the shared client
+#ifndef DX_HTTP_MAX_CONNECTIONS
+#define DX_HTTP_MAX_CONNECTIONS 8
+#endif
+
+/// <summary>
+/// Called on the event loop when a request completes. succeeded is false if the request failed at the transport level
+/// (DNS, connect, TLS, timeout), httpStatus is the response status code, 0 if no response was received.
+/// body is null terminated and only valid for the duration of the call.
+/// </summary>
+typedef void (*DX_HTTP_RESPONSE_HANDLER)(bool succeeded, long httpStatus, const char *body, size_t bodyLength, void *context);
+
+/// <summary>
+/// Optional, called on the event loop as response data arrives. When set the body is not accumulated and the response
+/// handler is passed a NULL body. Return false to abort the request.
+/// </summary>
+typedef bool (*DX_HTTP_DATA_HANDLER)(const char *data, size_t length, void *context);
+
+typedef struct
+{
+    const char *url;
+    const struct curl_slist *headers; // optional, must remain valid until the response handler is called
+    const char *postData;             // NULL for a GET, copied so the caller can release it once the call returns
+    long timeoutSeconds;              // 0 for no timeout
+    DX_HTTP_DATA_HANDLER dataHandler;
+    DX_HTTP_RESPONSE_HANDLER responseHandler;
+    void *context;
+} DX_HTTP_REQUEST;
+
+/// <summary>
+/// Start an HTTP request on the shared client. Requests run on the libuv event loop using curl-multi, connections and TLS
+/// sessions are kept alive and reused per host. Returns false if the request could not be started, in which case the
+/// response handler is not called.
+/// </summary>
+/// <param name="request"></param>
+/// <returns></returns>
+bool dx_httpRequestAsync(const DX_HTTP_REQUEST *request);
+
+/// <summary>
+/// Cancel all in-flight requests, their response handlers are called with succeeded false, and close pooled connections
+/// </summary>
+/// <param name=""></param>
+void dx_httpCleanup(void);
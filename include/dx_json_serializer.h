@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -11,6 +12,34 @@ typedef enum {
     DX_JSON_DOUBLE
 } DX_JSON_TYPE;
 
+typedef struct {
+    DX_JSON_TYPE type;
+    const char *name;
+    int precision; // decimal places for DX_JSON_FLOAT and DX_JSON_DOUBLE, trailing zeros are trimmed. 0 writes the value losslessly
+} DX_JSON_FIELD;
+
+/// <summary>
+/// A fixed shape JSON object. The member names are escaped and quoted once by dx_jsonSchemaInit so serializing a
+/// message only writes values.
+/// </summary>
+typedef struct {
+    DX_JSON_FIELD *fields;
+    size_t field_count;
+    char *__keys;          // '{' or ',' then the quoted name and ':' for each field, in field order
+    size_t *__key_offsets; // field_count + 1 offsets into __keys
+} DX_JSON_SCHEMA;
+
+/// <summary>
+/// Writes JSON directly into a caller supplied buffer. overflow is set, and the buffer left null terminated, if the
+/// output did not fit.
+/// </summary>
+typedef struct {
+    char *buffer;
+    size_t size;
+    size_t length;
+    bool overflow;
+} DX_JSON_WRITER;
+
 /// <summary>
 /// JSON Serializer. Pass in a variable number of JSON Key Value Pairs
 /// </summary>
@@ -18,8 +47,55 @@ typedef enum {
 /// <param name="buffer_size">Size of JSON string</param>
 /// <param name="key_value_pair_count">The number of Key Value Pairs to serialize as JSON</param>
 /// <param name="">
-/// Data to be serialised must be passed in groups of three (JSON type, key name, key value). The value passed must match the type. 
+/// Data to be serialised must be passed in groups of three (JSON type, key name, key value). The value passed must match the type.
 /// Examples: DX_JSON_DOUBLE, "Temperature", temperature, DX_JSON_INT, "Humidity", humidity, DX_JSON_STRING, "Status", "cooling"
 /// </param>
 /// <returns></returns>
-bool dx_jsonSerialize(char* buffer, size_t buffer_size, int key_value_pair_count, ...);
\ No newline at end of file
+bool dx_jsonSerialize(char* buffer, size_t buffer_size, int key_value_pair_count, ...);
+
+/// <summary>
+/// Prepare a schema for dx_jsonSchemaSerialize, call once at startup
+/// </summary>
+/// <param name="schema"></param>
+/// <returns>false if the pre-escaped names could not be allocated</returns>
+bool dx_jsonSchemaInit(DX_JSON_SCHEMA *schema);
+
+/// <summary>
+/// Release the pre-escaped names allocated by dx_jsonSchemaInit
+/// </summary>
+/// <param name="schema"></param>
+void dx_jsonSchemaFree(DX_JSON_SCHEMA *schema);
+
+/// <summary>
+/// Serialize one value per schema field, in field order, into buffer. No memory is allocated.
+/// Example: dx_jsonSchemaSerialize(&telemetry_schema, msgBuffer, sizeof(msgBuffer), temperature, humidity, "cooling")
+/// </summary>
+/// <param name="schema">A schema prepared by dx_jsonSchemaInit</param>
+/// <param name="buffer">Buffer for JSON string result</param>
+/// <param name="buffer_size">Size of buffer</param>
+/// <param name="">The values, which must match the field types</param>
+/// <returns>false if the result did not fit in the buffer</returns>
+bool dx_jsonSchemaSerialize(const DX_JSON_SCHEMA *schema, char *buffer, size_t buffer_size, ...);
+
+void dx_jsonWriterInit(DX_JSON_WRITER *writer, char *buffer, size_t buffer_size);
+void dx_jsonWriteRaw(DX_JSON_WRITER *writer, const char *text, size_t length);
+void dx_jsonWriteString(DX_JSON_WRITER *writer, const char *value);
+void dx_jsonWriteInt(DX_JSON_WRITER *writer, long long value);
+void dx_jsonWriteBool(DX_JSON_WRITER *writer, bool value);
+
+/// <summary>
+/// Write a JSON object from (JSON type, key name, key value) triples taken from valist, as dx_jsonSerialize does
+/// </summary>
+/// <returns>false if a type was not recognised or the writer has overflowed</returns>
+bool dx_jsonWriteFields(DX_JSON_WRITER *writer, int key_value_pair_count, va_list *valist);
+
+/// <summary>
+/// Write a number with up to precision decimal places, trailing zeros are trimmed. NaN and infinity are written as null.
+/// </summary>
+void dx_jsonWriteNumber(DX_JSON_WRITER *writer, double value, int precision);
+
+/// <summary>
+/// Write a number that reads back as the same double, with the fewest decimal places that do. NaN and infinity are written
+/// as null.
+/// </summary>
+void dx_jsonWriteDouble(DX_JSON_WRITER *writer, double value);
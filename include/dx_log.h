@@ -0,0 +1,66 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bytes per log record, longer messages are truncated
+#ifndef DX_LOG_RECORD_SIZE
+#define DX_LOG_RECORD_SIZE 256
+#endif
+
+// Records buffered for the flusher thread, messages logged while the ring is full are dropped and counted
+#ifndef DX_LOG_RING_SIZE
+#define DX_LOG_RING_SIZE 256
+#endif
+
+// Messages per second from one format string before further messages are suppressed, 0 for no limit
+#ifndef DX_LOG_RATE_LIMIT
+#define DX_LOG_RATE_LIMIT 0
+#endif
+
+typedef enum
+{
+    DX_LOG_ERROR = 0,
+    DX_LOG_WARNING = 1,
+    DX_LOG_INFO = 2,
+    DX_LOG_DEBUG = 3
+} DX_LOG_LEVEL;
+
+/// <summary>
+/// Log a message at the given level. Messages above the current level are discarded before formatting. Messages are
+/// formatted on the calling thread into a lock free ring and written to stdout in batches by a background thread.
+/// Safe to call from any thread.
+/// </summary>
+/// <param name="level"></param>
+/// <param name="fmt"></param>
+/// <param name=""></param>
+void dx_Log(DX_LOG_LEVEL level, const char *fmt, ...);
+
+/// <summary>
+/// Log at DX_LOG_DEBUG level
+/// </summary>
+/// <param name="fmt"></param>
+/// <param name=""></param>
+void dx_Log_Debug(char *fmt, ...);
+
+/// <summary>
+/// Retained for compatibility, messages are formatted into the log ring so the buffer is no longer used
+/// </summary>
+/// <param name="buffer"></param>
+/// <param name="buffer_size"></param>
+void dx_Log_Debug_Init(char *buffer, size_t buffer_size);
+
+/// <summary>
+/// Write any buffered messages before returning
+/// </summary>
+/// <param name=""></param>
+void dx_logFlush(void);
+
+/// <summary>
+/// Set the most verbose level logged, the default is DX_LOG_DEBUG
+/// </summary>
+/// <param name="level"></param>
+void dx_logSetLevel(DX_LOG_LEVEL level);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Open addressed hash over a fixed set of names, built once and kept at most half full so a lookup probes a short
+// run of slots. Entries are item index + 1, 0 means not found.
+typedef struct {
+    size_t *slots;
+    uint32_t *hashes; // hash of the name in each occupied slot, compared before the name
+    size_t *chain;    // next entry with the same name, NULL when duplicates are not chained
+    size_t size;
+} DX_NAME_INDEX;
+
+typedef const char *(*DX_NAME_INDEX_NAME_OF)(size_t item, void *context);
+
+/// <summary>
+/// Index the names of itemCount items, the table has the next power of two at or above twice the item count.
+/// When chainDuplicates is false the first item with a name wins, otherwise later items are chained from it.
+/// </summary>
+/// <param name="index"></param>
+/// <param name="itemCount"></param>
+/// <param name="nameOf">Returns the name of an item</param>
+/// <param name="context"></param>
+/// <param name="chainDuplicates"></param>
+/// <returns></returns>
+bool dx_nameIndexBuild(DX_NAME_INDEX *index, size_t itemCount, DX_NAME_INDEX_NAME_OF nameOf, void *context, bool chainDuplicates);
+
+/// <summary>
+/// Returns item index + 1 of the first item with the name, or 0 if not found
+/// </summary>
+/// <param name="index"></param>
+/// <param name="name"></param>
+/// <param name="nameOf"></param>
+/// <param name="context"></param>
+/// <returns></returns>
+size_t dx_nameIndexFind(const DX_NAME_INDEX *index, const char *name, DX_NAME_INDEX_NAME_OF nameOf, void *context);
+
+/// <summary>
+/// Returns the next entry with the same name as entry, or 0 at the end of the chain
+/// </summary>
+/// <param name="index"></param>
+/// <param name="entry"></param>
+/// <returns></returns>
+size_t dx_nameIndexNext(const DX_NAME_INDEX *index, size_t entry);
+
+void dx_nameIndexFree(DX_NAME_INDEX *index);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdbool.h>
+
 typedef struct
 {
     const char *assistant_msg;
@@ -9,8 +11,15 @@ typedef struct
     void (*openai_function_handler)(const char *content, const char *finish_reason, const char *function_call_name, const char *function_call_arguments);
     void *json_root;
     struct curl_slist *headers;
+    bool stream; // stream the response as server-sent events, openai_function_handler is called once the function call is complete
 } DX_OPENAI_FUNCTION_CTX;
 
 void dx_openai_function_free(DX_OPENAI_FUNCTION_CTX *ctx);
 void dx_openai_function_init(DX_OPENAI_FUNCTION_CTX *ctx, const char *filename, const char *openai_api_key);
+
+/// <summary>
+/// Post the conversation to the OpenAI endpoint without blocking, openai_function_handler is called on the event loop
+/// when the response arrives. The ctx must remain valid until then.
+/// </summary>
+/// <param name="ctx"></param>
 void dx_openai_function_post_request(DX_OPENAI_FUNCTION_CTX *ctx);
\ No newline at end of file
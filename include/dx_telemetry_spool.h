@@ -0,0 +1,73 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#pragma once
+
+#include "dx_azure_iot.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Maximum number of replayed messages awaiting IoT Hub acknowledgement, at most 256
+#ifndef DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT
+#define DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT 32
+#endif
+
+// Maximum number of application properties stored with a spooled message
+#ifndef DX_TELEMETRY_SPOOL_MAX_PROPERTIES
+#define DX_TELEMETRY_SPOOL_MAX_PROPERTIES 16
+#endif
+
+typedef struct {
+    const char *path;                // spool file, created if it does not exist
+    size_t capacity;                 // bytes of record storage, the file is this size plus a one page header
+    unsigned int drainRatePerSecond; // messages per second replayed once reconnected, 0 defaults to 10
+    unsigned int maxInFlight;        // replayed messages awaiting acknowledgement, 0 or above DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT defaults to the max
+} DX_TELEMETRY_SPOOL_CONFIG;
+
+/// <summary>
+/// Open (or create) the on-disk telemetry spool. While the spool is open, dx_azurePublish stores messages in the spool when
+/// there is no connection to Azure IoT, and once IoT Hub reports the connection authenticated the spool is replayed at
+/// drainRatePerSecond, subject to the publish window. The spool is a memory mapped ring of length prefixed records, the
+/// acknowledged offset is checkpointed so unacknowledged records are replayed after a restart (delivery is at least once).
+/// </summary>
+/// <param name="config"></param>
+/// <returns></returns>
+bool dx_telemetrySpoolOpen(DX_TELEMETRY_SPOOL_CONFIG *config);
+
+/// <summary>
+/// Checkpoint and close the telemetry spool
+/// </summary>
+/// <param name=""></param>
+void dx_telemetrySpoolClose(void);
+
+/// <summary>
+/// Append a message to the spool. Returns false if the spool is not open or is full.
+/// </summary>
+/// <param name="message"></param>
+/// <param name="messageLength"></param>
+/// <param name="messageProperties"></param>
+/// <param name="messagePropertyCount"></param>
+/// <param name="messageContentProperties"></param>
+/// <returns></returns>
+bool dx_telemetrySpoolAppend(const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties, size_t messagePropertyCount,
+                             DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties);
+
+/// <summary>
+/// Start replaying the spool, called when IoT Hub reports the connection is authenticated
+/// </summary>
+/// <param name=""></param>
+void dx_telemetrySpoolResume(void);
+
+/// <summary>
+/// Check if the spool is open
+/// </summary>
+/// <param name=""></param>
+/// <returns></returns>
+bool dx_telemetrySpoolIsOpen(void);
+
+/// <summary>
+/// Bytes of spooled records not yet acknowledged by IoT Hub
+/// </summary>
+/// <param name=""></param>
+/// <returns></returns>
+size_t dx_telemetrySpoolPendingBytes(void);
@@ -2,6 +2,7 @@
 
 #include "dx_terminate.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <uv.h>
 
 #define DX_TIMER_HANDLER(name)                \
@@ -20,6 +21,17 @@
 typedef uv_timer_t EventLoopTimer;
 typedef struct timespec timespec;
 
+// Resolution of the timer wheel used by timers with a tolerance
+#ifndef DX_TIMER_WHEEL_TICK_MS
+#define DX_TIMER_WHEEL_TICK_MS 10
+#endif
+
+typedef struct _dxTimerWheelNode
+{
+	struct _dxTimerWheelNode *next;
+	struct _dxTimerWheelNode *prev;
+} DX_TIMER_WHEEL_NODE;
+
 typedef struct
 {
 	void (*handler)(uv_timer_t *handle);
@@ -28,6 +40,12 @@ typedef struct
 	const char *name;
 	bool initialized;
 	uv_timer_t timer_handle;
+	// Optional. When non zero the timer is scheduled on a shared timer wheel instead of its own libuv timer and may fire up
+	// to tolerance_ms late, timers with overlapping windows are coalesced into the same wakeup.
+	unsigned int tolerance_ms;
+	DX_TIMER_WHEEL_NODE __wheel_node;
+	uint64_t __wheel_expiry; // deadline in loop time ms
+	uint64_t __wheel_period_ms;
 } DX_TIMER_BINDING;
 
 int ConsumeEventLoopTimerEvent(EventLoopTimer *eventLoopTimer);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "dx_log.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
@@ -12,6 +13,13 @@
 #define DX_SAFE_STRING_COPY(dest, source, length) strncpy(dest, source, length); dest[length - 1] = 0x00;
 
 bool dx_isDeviceAuthReady(void);
+
+/// <summary>
+/// Check the network is up. When a network interface is given an end to end probe is also started on the event loop, the
+/// last probe result is returned without waiting and reachability changes are reported to the reachability callback.
+/// </summary>
+/// <param name="networkInterface"></param>
+/// <returns></returns>
 bool dx_isNetworkConnected(const char *networkInterface);
 bool dx_isNetworkReady(void);
 bool dx_isStringNullOrEmpty(const char *string);
@@ -31,5 +39,5 @@ char *dx_getHttpData(const char *url, long timeout);
 char *dx_getLocalTime(char *buffer, size_t bufferSize);
 int dx_stringEndsWith(const char *str, const char *suffix);
 int64_t dx_getNowMilliseconds(void);
-void dx_Log_Debug(char *fmt, ...);
-void dx_Log_Debug_Init(char *buffer, size_t buffer_size);
+void dx_setNetworkReachabilityCallback(void (*reachabilityChanged)(bool connected));
+
@@ -0,0 +1,66 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#pragma once
+
+#include <stdbool.h>
+#include <uv.h>
+
+#define DX_WORK_HANDLER(name, work) void name(DX_WORK *work) {
+
+#define DX_WORK_HANDLER_END }
+
+#define DX_DECLARE_WORK_HANDLER(name) void name(DX_WORK *work)
+
+#define DX_AFTER_WORK_HANDLER(name, work, cancelled) void name(DX_WORK *work, bool cancelled) {
+
+#define DX_AFTER_WORK_HANDLER_END }
+
+#define DX_DECLARE_AFTER_WORK_HANDLER(name) void name(DX_WORK *work, bool cancelled)
+
+typedef enum {
+  DX_WORK_IDLE,
+  DX_WORK_PENDING, // waiting for a slot in its work queue
+  DX_WORK_QUEUED   // handed to the libuv thread pool, queued or running
+} DX_WORK_STATE;
+
+struct _dxWork;
+
+// Bounds how many of its work items run on the thread pool at once, items over the limit wait in submission order
+typedef struct {
+  const char *name;
+  unsigned int max_concurrency; // 0 for no limit
+  unsigned int __running;
+  struct _dxWork *__pending_head;
+  struct _dxWork *__pending_tail;
+} DX_WORK_QUEUE;
+
+typedef struct _dxWork {
+  char *name;
+  void (*work)(struct _dxWork *work);                        // runs on a thread pool thread
+  void (*after_work)(struct _dxWork *work, bool cancelled);  // runs on the event loop thread, optional
+  DX_WORK_QUEUE *queue;                                      // optional
+  void *context;
+  DX_WORK_STATE __state;
+  uv_work_t __request;
+  struct _dxWork *__next;
+} DX_WORK;
+
+/// <summary>
+/// Run work->work on the libuv thread pool and work->after_work on the event loop thread once it completes. The DX_WORK is
+/// owned by the caller and must remain valid until after_work is called. Call from the event loop thread. Returns false if
+/// the work is already submitted or could not be queued, after_work is not called. Work waiting in its queue that later
+/// fails to start is reported with cancelled true. The pool size is set with the UV_THREADPOOL_SIZE environment variable
+/// (default 4).
+/// </summary>
+/// <param name="work"></param>
+/// <returns></returns>
+bool dx_workSubmit(DX_WORK *work);
+
+/// <summary>
+/// Cancel work that has not started running, after_work is called with cancelled true. Returns false if the work is
+/// already running or complete. Call from the event loop thread.
+/// </summary>
+/// <param name="work"></param>
+/// <returns></returns>
+bool dx_workCancel(DX_WORK *work);
@@ -3,27 +3,174 @@
 
 #include "dx_async.h"
 #include "dx_terminate.h"
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 // http://docs.libuv.org/en/v1.x/async.html
 
+/*
+	Bounded multi producer single consumer ring, https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+	Each cell carries a sequence number, producers claim a position with a CAS on the enqueue position and publish the
+	cell by advancing its sequence. The event loop is the only consumer so the dequeue position needs no atomics.
+*/
+typedef struct
+{
+	atomic_size_t sequence;
+	void *data;
+} ASYNC_QUEUE_CELL;
+
+typedef struct
+{
+	ASYNC_QUEUE_CELL *cells;
+	size_t mask;
+	atomic_size_t enqueue_pos;
+	size_t dequeue_pos;
+} ASYNC_QUEUE;
+
+static bool queue_push(ASYNC_QUEUE *queue, void *data)
+{
+	ASYNC_QUEUE_CELL *cell;
+	size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+
+	for (;;)
+	{
+		cell         = &queue->cells[pos & queue->mask];
+		size_t seq   = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+		intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+		if (dif == 0)
+		{
+			if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (dif < 0)
+		{
+			// full
+			return false;
+		}
+		else
+		{
+			pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+		}
+	}
+
+	cell->data = data;
+	atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+
+	return true;
+}
+
+static bool queue_pop(ASYNC_QUEUE *queue, void **data)
+{
+	ASYNC_QUEUE_CELL *cell = &queue->cells[queue->dequeue_pos & queue->mask];
+	size_t seq             = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+
+	// empty, or the producer has claimed the cell but not yet published it and will signal again once it has
+	if (seq != queue->dequeue_pos + 1)
+	{
+		return false;
+	}
+
+	*data = cell->data;
+	atomic_store_explicit(&cell->sequence, queue->dequeue_pos + queue->mask + 1, memory_order_release);
+	queue->dequeue_pos++;
+
+	return true;
+}
+
+static void queue_drain(uv_async_t *handle)
+{
+	DX_ASYNC_BINDING *binding = (DX_ASYNC_BINDING *)((char *)handle - offsetof(DX_ASYNC_BINDING, async));
+	void *data;
+
+	// libuv coalesces sends, so drain everything queued before this wakeup
+	while (queue_pop(binding->__queue, &data))
+	{
+		handle->data = data;
+		binding->handler(handle);
+	}
+}
+
+static ASYNC_QUEUE *queue_create(size_t queue_size)
+{
+	ASYNC_QUEUE *queue = calloc(1, sizeof(ASYNC_QUEUE));
+	size_t size        = 2;
+
+	if (!queue)
+	{
+		return NULL;
+	}
+
+	while (size < queue_size)
+	{
+		size <<= 1;
+	}
+
+	if (!(queue->cells = calloc(size, sizeof(ASYNC_QUEUE_CELL))))
+	{
+		free(queue);
+		return NULL;
+	}
+
+	for (size_t i = 0; i < size; i++)
+	{
+		atomic_init(&queue->cells[i].sequence, i);
+	}
+
+	queue->mask = size - 1;
+	atomic_init(&queue->enqueue_pos, 0);
+
+	return queue;
+}
+
 void dx_asyncInit(DX_ASYNC_BINDING *binding)
 {
-	if (uv_async_init(uv_default_loop(), &binding->async, binding->handler) < 0)
+	uv_async_cb callback = binding->handler;
+
+	if (binding->queue_size)
+	{
+		if (!binding->__queue && !(binding->__queue = queue_create(binding->queue_size)))
+		{
+			printf("async queue allocation failed for %s\n", binding->name);
+			dx_terminate(DX_ExitCode_Async_Init_Failed);
+			return;
+		}
+		callback = queue_drain;
+	}
+
+	if (uv_async_init(uv_default_loop(), &binding->async, callback) < 0)
 	{
 		printf("uv_async_init failed for %s\n", binding->name);
 		dx_terminate(DX_ExitCode_Async_Init_Failed);
 	}
 }
 
-void dx_asyncSend(DX_ASYNC_BINDING *binding, void *data)
+bool dx_asyncSend(DX_ASYNC_BINDING *binding, void *data)
 {
-	binding->async.data = data;
+	if (binding->__queue)
+	{
+		if (!queue_push(binding->__queue, data))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		binding->async.data = data;
+	}
+
 	if (uv_async_send(&binding->async) < 0)
 	{
 		printf("uv_async_send failed for %s\n", binding->name);
 		dx_terminate(DX_ExitCode_Async_Send_Failed);
+		return false;
 	}
+
+	return true;
 }
 
 void dx_asyncSetInit(DX_ASYNC_BINDING *asyncSet[], size_t asyncCount)
@@ -39,8 +39,18 @@ static char deviceGUID[DX_AVNET_IOT_CONNECT_GUID_LEN + 1];
 static char entityGUID[DX_AVNET_IOT_CONNECT_GUID_LEN + 1];
 static bool avnetConnected = false;
 
-// Define a pointer to a linked list of children devices/nodes for gateway implementations
-gw_child_list_node_t* gwChildrenListHead = NULL;
+// Gateway children are kept in a contiguous array with an open addressing (linear probe) index on the id.
+// Index slots hold child index + 1, 0 is empty.
+static gw_child_list_node_t *gwChildren = NULL;
+static size_t gwChildCount = 0;
+static size_t gwChildCapacity = 0;
+static size_t *gwChildIndex = NULL;
+static size_t gwChildIndexSize = 0;
+
+// Interned tag strings, an open addressing set that drops tags no child uses whenever it fills up
+static char **gwTags = NULL;
+static size_t gwTagCount = 0;
+static size_t gwTagIndexSize = 0;
 
 // Wait for 15 seconds for IoT Connect to send the hello message
 static const int AVNET_IOT_DEFAULT_POLL_PERIOD_SECONDS = 15; 
@@ -59,16 +69,13 @@ static bool IoTCProcess221Response(JSON_Object *dProperties);
 static void IoTCSend222DeleteChildMessage(gw_child_list_node_t* childToDelete);
 static bool IoTCProcess222Response(JSON_Object *dProperties);
 
-// Routines associated with gateway implementations and managing the linked list of children devices
-bool IoTCListAddChild(const char* id, const char* tg);
+// Routines associated with gateway implementations and managing the list of children devices
+static gw_child_list_node_t* IoTCListAddChild(const char* id, const char* tg);
 void IoTClistDelete(void);
-bool IoTCListDeleteNode(gw_child_list_node_t* nodeToRemove);
-bool IoTCListDeleteNodeById(const char* id);
-gw_child_list_node_t* IoTCListGetNewNode(const char* id, const char* tg);
-gw_child_list_node_t* IoTCListInsertNode(const char* id, const char* tg);
-gw_child_list_node_t* IoTCListFindNode(char* id);
-gw_child_list_node_t* IoTCListFindNodeById(const char* id);
-
+static bool IoTCListRebuildIndex(size_t size);
+static bool IoTCListReserve(size_t count);
+static bool IoTCListDeleteNodeById(const char* id);
+static gw_child_list_node_t* IoTCListFindNodeById(const char* id);
 
 static DX_TIMER_BINDING monitorAvnetConnectionTimer = {.name = "monitorAvnetConnectionTimer", .handler = MonitorAvnetConnectionHandler};
 
@@ -237,167 +244,143 @@ static void IoTCSend200HelloMessage(void)
     json_value_free(rootValue);
 }
 
-// Construct a new message that contains all the required IoTConnect data and the original telemetry
-// message. Returns false if we have not received the first response from IoTConnect, if the
-// target buffer is not large enough, or if the incoming data is not valid JSON.
-bool dx_avnetJsonSerializePayload(const char *originalJsonMessage, char *modifiedJsonMessage, size_t modifiedBufferSize, gw_child_list_node_t* childDevice)
+/// <summary>
+/// Cheap structural check used instead of a full parse, the telemetry must be a JSON object
+/// </summary>
+static bool IoTCIsJsonObject(const char *json, size_t *length)
 {
+    const char *start = json;
+    const char *end = json + strlen(json);
 
-    bool result = false;
-
-    // Verify that the incoming JSON is valid
-    JSON_Value *rootProperties = NULL;
-    rootProperties = json_parse_string(originalJsonMessage);
-    if (rootProperties != NULL) {
-
-        // Define the Json string format for sending telemetry to IoT Connect, note that the
-        // actual telemetry data is inserted as the last string argument
-        static const char IoTCTelemetryJson[] = "{\"sid\":\"%s\",\"dtg\":\"%s\",\"mt\":0,\"d\":[{\"d\":%s}]}";
-        static const char IoTCGwTelemetryJson[] = "{\"sid\":\"%s\",\"dtg\":\"%s\",\"mt\":0,\"d\":[{\"id\":\"%s\",\"tg\":\"%s\",\"d\":%s}]}";
-
-        // Determine the largest message size needed.  We'll use this to validate the incoming target
-        // buffer is large enough
-        size_t maxModifiedMessageSize = strlen(originalJsonMessage) + DX_AVNET_IOT_CONNECT_METADATA;
-
-        // Verify that the passed in buffer is large enough for the modified message
-        if (maxModifiedMessageSize > modifiedBufferSize) {
-            Log_Debug(
-                "\n[AVT IoTConnect] "
-                "ERROR: dx_avnetJsonSerializePayload() modified buffer size can't hold modified "
-                "message\n");
-            Log_Debug("[AVT IoTConnect]                  Original message size: %d\n", (int)strlen(originalJsonMessage));
-            Log_Debug("[AVT IoTConnect] Additional IoTConnect message overhead: %d\n", DX_AVNET_IOT_CONNECT_METADATA);
-            Log_Debug("[AVT IoTConnect]            Required target buffer size: %d\n", (int)maxModifiedMessageSize);
-            Log_Debug("[AVT IoTConnect]               Actual target buffersize: %d\n\n", (int)modifiedBufferSize);
-
-            result = false;
-            goto cleanup;
-        }
+    while (*start == ' ' || *start == '\t' || *start == '\r' || *start == '\n') {
+        start++;
+    }
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n')) {
+        end--;
+    }
 
-        // Build up the IoTC message and insert the telemetry JSON
-        if(childDevice != NULL){
-            snprintf(modifiedJsonMessage, maxModifiedMessageSize, IoTCGwTelemetryJson, sidString, dtgGUID, childDevice->id, childDevice->tg, originalJsonMessage);
-        }
-        else{
-            snprintf(modifiedJsonMessage, maxModifiedMessageSize, IoTCTelemetryJson, sidString, dtgGUID, originalJsonMessage);
-        }
-       
-        result = true;
+    *length = (size_t)(end - json);
+    return end - start >= 2 && *start == '{' && end[-1] == '}';
+}
+
+bool dx_avnetEnvelopeBegin(DX_AVNET_ENVELOPE *envelope, char *buffer, size_t bufferSize)
+{
+    static const char mtAndRecords[] = ",\"mt\":0,\"d\":[";
 
+    envelope->recordCount = 0;
+    dx_jsonWriterInit(&envelope->writer, buffer, bufferSize);
+
+    // {"sid":"<sid>","dtg":"<dtg>","mt":0,"d":[
+    dx_jsonWriteRaw(&envelope->writer, "{\"sid\":", 7);
+    dx_jsonWriteString(&envelope->writer, sidString);
+    dx_jsonWriteRaw(&envelope->writer, ",\"dtg\":", 7);
+    dx_jsonWriteString(&envelope->writer, dtgGUID);
+    dx_jsonWriteRaw(&envelope->writer, mtAndRecords, sizeof(mtAndRecords) - 1);
+
+    return !envelope->writer.overflow;
+}
+
+static void IoTCEnvelopeRecordHeader(DX_AVNET_ENVELOPE *envelope, gw_child_list_node_t *childDevice)
+{
+    if (envelope->recordCount++ > 0) {
+        dx_jsonWriteRaw(&envelope->writer, ",", 1);
     }
-    else{
-        Log_Debug("[AVT IoTConnect] ERROR: dx_avnetJsonSerializePayload was passed invalid JSON\n");
+
+    // Gateway child records carry the child id and tag: {"id":"<id>","tg":"<tg>","d":<telemetry>}
+    if (childDevice != NULL) {
+        dx_jsonWriteRaw(&envelope->writer, "{\"id\":", 6);
+        dx_jsonWriteString(&envelope->writer, childDevice->id);
+        dx_jsonWriteRaw(&envelope->writer, ",\"tg\":", 6);
+        dx_jsonWriteString(&envelope->writer, childDevice->tg);
+        dx_jsonWriteRaw(&envelope->writer, ",\"d\":", 5);
+    } else {
+        dx_jsonWriteRaw(&envelope->writer, "{\"d\":", 5);
     }
+}
 
-cleanup:
-    // Release the allocated memory.
-    json_value_free(rootProperties);
+bool dx_avnetEnvelopeAddRecord(DX_AVNET_ENVELOPE *envelope, gw_child_list_node_t *childDevice, const char *telemetryJson)
+{
+    size_t length;
 
-    return result;
+    if (telemetryJson == NULL || !IoTCIsJsonObject(telemetryJson, &length)) {
+        Log_Debug("[AVT IoTConnect] ERROR: dx_avnetEnvelopeAddRecord was passed invalid JSON\n");
+        return false;
+    }
+
+    IoTCEnvelopeRecordHeader(envelope, childDevice);
+    dx_jsonWriteRaw(&envelope->writer, telemetryJson, length);
+    dx_jsonWriteRaw(&envelope->writer, "}", 1);
+
+    return !envelope->writer.overflow;
 }
 
-bool dx_avnetJsonSerialize(char *jsonMessageBuffer, size_t bufferSize, gw_child_list_node_t* childDevice, int key_value_pair_count, ...)
+static bool IoTCEnvelopeAddFields(DX_AVNET_ENVELOPE *envelope, gw_child_list_node_t *childDevice, int key_value_pair_count, va_list *valist)
 {
-    bool result = false;
-    char *serializedJson = NULL;
-    char *keyString = NULL;
-    int dataType;
-
-    // Prepare the JSON object for the telemetry data
-    JSON_Value *root_value = json_value_init_object();
-    JSON_Object *root_object = json_value_get_object(root_value);
-
-    // Create a Json_Array
-    JSON_Value *myArrayValue = json_value_init_array();
-    JSON_Array *myArray = json_value_get_array(myArrayValue);
-
-    // Prepare the JSON object for the telemetry data
-    JSON_Value *array_value_object = json_value_init_object();
-    JSON_Object *array_object = json_value_get_object(array_value_object);
-
-    // Allocate a buffer that we used to dynamically create the list key names d.<keyname>
-    char *keyBuffer = (char *)malloc(DX_AVNET_IOT_CONNECT_JSON_BUFFER_SIZE);
-    if (keyBuffer == NULL) {
-        Log_Debug("[AVT IoTConnect] ERROR: not enough memory to send telemetry.");
+    IoTCEnvelopeRecordHeader(envelope, childDevice);
+
+    if (!dx_jsonWriteFields(&envelope->writer, key_value_pair_count, valist)) {
         return false;
     }
 
-    // We need to format the data as shown below
-    // "{\"sid\":\"%s\",\"dtg\":\"%s\",\"mt\": 0,\"dt\": \"%s\",\"d\":[{\"d\":<new telemetry "key": value pairs>}]}";
-
-    serializedJson = NULL;
-    json_object_dotset_string(root_object, "sid", sidString);
-    json_object_dotset_string(root_object, "dtg", dtgGUID);
-    json_object_dotset_number(root_object, "mt", 0);
-
-    // If the telemetry is for a GW child device, then add the child id and tag strings
-    // "{\"sid\":\"%s\",\"dtg\":\"%s\",\"mt\":0,\"d\":[{\"id\":\"%s\",\"tg\":\"%s\",\"d\":%s}]}";
-    //                                                    ^^^^^^^^^^^^^^^^^^^^^^^^^
-    if(childDevice != NULL){
-        json_object_dotset_string(array_object, "id", childDevice->id);    
-        json_object_dotset_string(array_object, "tg", childDevice->tg);    
-    }
+    dx_jsonWriteRaw(&envelope->writer, "}", 1);
 
-    // Prepare the argument list
-    va_list inputList;
-    va_start(inputList, key_value_pair_count);
+    return !envelope->writer.overflow;
+}
 
-    // Consume the data in the argument list and build out the json
-    while (key_value_pair_count--) {
+bool dx_avnetEnvelopeAddFields(DX_AVNET_ENVELOPE *envelope, gw_child_list_node_t *childDevice, int key_value_pair_count, ...)
+{
+    bool result;
 
-        // Pull the data type from the list
-        dataType = va_arg(inputList, int);
+    va_list inputList;
+    va_start(inputList, key_value_pair_count);
+    result = IoTCEnvelopeAddFields(envelope, childDevice, key_value_pair_count, &inputList);
+    va_end(inputList);
 
-        // Pull the current "key"
-        keyString = va_arg(inputList, char *);
+    return result;
+}
 
-        // "d.<newKey>: <value>"
-        snprintf(keyBuffer, DX_AVNET_IOT_CONNECT_JSON_BUFFER_SIZE, "d.%s", keyString);
-        switch (dataType) {
+bool dx_avnetEnvelopeEnd(DX_AVNET_ENVELOPE *envelope)
+{
+    dx_jsonWriteRaw(&envelope->writer, "]}", 2);
 
-            // report current device twin data as reported properties to IoTHub
-        case DX_JSON_BOOL:
-            json_object_dotset_boolean(array_object, keyBuffer, va_arg(inputList, int));
-            break;
-        case DX_JSON_FLOAT:
-        case DX_JSON_DOUBLE:
-            json_object_dotset_number(array_object, keyBuffer, va_arg(inputList, double));
-            break;
-        case DX_JSON_INT:
-            json_object_dotset_number(array_object, keyBuffer, va_arg(inputList, int));
-            break;
-        case DX_JSON_STRING:
-            json_object_dotset_string(array_object, keyBuffer, va_arg(inputList, char *));
-            break;
-        default:
-            result = false;
-            goto cleanup;
-        }
+    if (envelope->writer.overflow) {
+        Log_Debug("[AVT IoTConnect] ERROR: IoTConnect message does not fit in a %d byte buffer\n", (int)envelope->writer.size);
+        return false;
     }
 
-    // Clean up the argument list
-    va_end(inputList);
+    return true;
+}
 
-    // Add the telemetry data to the Json
-    json_array_append_value(myArray, array_value_object);
-    json_object_dotset_value(root_object, "d", myArrayValue);
+// Construct a new message that contains all the required IoTConnect data and the original telemetry
+// message. Returns false if the target buffer is not large enough, or if the incoming data is not a JSON object.
+bool dx_avnetJsonSerializePayload(const char *originalJsonMessage, char *modifiedJsonMessage, size_t modifiedBufferSize, gw_child_list_node_t* childDevice)
+{
+    DX_AVNET_ENVELOPE envelope;
 
-    // Serialize the structure
-    serializedJson = json_serialize_to_string(root_value);
+    dx_avnetEnvelopeBegin(&envelope, modifiedJsonMessage, modifiedBufferSize);
 
-    // Copy the new JSON into the buffer the calling routine passed in
-    if (strlen(serializedJson) < bufferSize) {
-        strncpy(jsonMessageBuffer, serializedJson, bufferSize);
-        result = true;
+    if (!dx_avnetEnvelopeAddRecord(&envelope, childDevice, originalJsonMessage)) {
+        return false;
     }
 
-cleanup:
-    // Clean up
-    json_free_serialized_string(serializedJson);
-    json_value_free(root_value);
-    free(keyBuffer);
+    return dx_avnetEnvelopeEnd(&envelope);
+}
 
-    return result;
+bool dx_avnetJsonSerialize(char *jsonMessageBuffer, size_t bufferSize, gw_child_list_node_t* childDevice, int key_value_pair_count, ...)
+{
+    DX_AVNET_ENVELOPE envelope;
+    bool result;
+
+    // We need to format the data as shown below
+    // "{\"sid\":\"%s\",\"dtg\":\"%s\",\"mt\": 0,\"d\":[{\"d\":<new telemetry "key": value pairs>}]}";
+    dx_avnetEnvelopeBegin(&envelope, jsonMessageBuffer, bufferSize);
+
+    va_list inputList;
+    va_start(inputList, key_value_pair_count);
+    result = IoTCEnvelopeAddFields(&envelope, childDevice, key_value_pair_count, &inputList);
+    va_end(inputList);
+
+    return result && dx_avnetEnvelopeEnd(&envelope);
 }
 
 bool dx_isAvnetConnected(void)
@@ -639,27 +622,59 @@ static bool IoTCProcess204Response(JSON_Object *dProperties){
         gwArray = json_object_dotget_array(dProperties, "d");
         if(gwArray != NULL){
 
-            // For each item in the array: Allocate a new gw_child_t structure, fill it in and add it to the 
-            // list of children
-            for(size_t i = 0; i < json_array_get_count(gwArray); i++){
+            size_t childEntries = json_array_get_count(gwArray);
+            size_t keep = 0;
+
+            // The 204 list is the complete set of children. Mark the children it contains, adding new ones and
+            // updating tags in place, then remove any child that is no longer on IoTConnect.
+            if(!IoTCListReserve(gwChildCount + childEntries)){
+                dx_terminate(DX_ExitCode_Avnet_Add_Child_Failed);
+                return false;
+            }
+
+            for(size_t i = 0; i < gwChildCount; i++){
+                gwChildren[i].__present = false;
+            }
+
+            for(size_t i = 0; i < childEntries; i++){
                 
                 // Get a pointer to the next object in the array
                 childEntry = json_array_get_object(gwArray, i);
 
-                // Check to see if this id is already in the list.  If so,then remove it and add it back in
-                // in case the tag changed
-                if(IoTCListFindNodeById((char*)json_object_get_string(childEntry, "id"))!= NULL){
-                    IoTCListDeleteNodeById((char*)json_object_get_string(childEntry,"id"));
-                }
+                const char *id = json_object_get_string(childEntry, "id");
+                const char *tg = json_object_get_string(childEntry, "tg");
 
-                //Log_Debug("[AVT IoTConnect] tg: %s\n", json_object_get_string(childEntry, "tg"));
-                //Log_Debug("[AVT IoTConnect] id: %s\n", json_object_get_string(childEntry, "id"));
+                if(id == NULL || tg == NULL){
+                    Log_Debug("[AVT IoTConnect] 204 child entry missing id or tg\n");
+                    continue;
+                }
 
-                // Add the child device to the linked list of children devices
-                if(!IoTCListAddChild(json_object_get_string(childEntry, "id"), json_object_get_string(childEntry, "tg"))){
+                // Add the child device, or update its tag if it is already in the list
+                gw_child_list_node_t *child = IoTCListAddChild(id, tg);
+                if(child == NULL){
 
                     dx_terminate(DX_ExitCode_Avnet_Add_Child_Failed);
+                    return false;
                 }
+
+                child->__present = true;
+            }
+
+            for(size_t i = 0; i < gwChildCount; i++){
+                if(gwChildren[i].__present){
+                    gwChildren[keep++] = gwChildren[i];
+                }
+                else{
+                    Log_Debug("[AVT IoTConnect] Removed GW Child id: %s, no longer on IoTConnect\n", gwChildren[i].id);
+                    free(gwChildren[i].id);
+                }
+            }
+
+            if(keep != gwChildCount){
+                gwChildCount = keep;
+
+                // same size, rebuilt in place
+                (void)IoTCListRebuildIndex(gwChildIndexSize);
             }
             
             // We have all the data we need set the IoTConnect Connected flag to true
@@ -746,12 +761,16 @@ gw_child_list_node_t *dx_avnetFindChild(const char* id){
 
 gw_child_list_node_t* dx_avnetGetFirstChild(void){
     
-    return gwChildrenListHead;
+    return gwChildCount > 0 ? &gwChildren[0] : NULL;
 }
 
 gw_child_list_node_t* dx_avnetGetNextChild(gw_child_list_node_t* currentChild){
 
-    return currentChild->next;
+    if(currentChild == NULL || currentChild + 1 >= gwChildren + gwChildCount){
+        return NULL;
+    }
+
+    return currentChild + 1;
 }
 
 void dx_avnetCreateChildOnIoTConnect(const char* id, const char* tg, const char* dn){
@@ -775,16 +794,6 @@ void dx_avnetDeleteChildOnIoTConnect(const char* id){
 }
 
 
-bool IoTCListAddChild(const char* id, const char* tg){
-
-    gw_child_list_node_t* newChildNode = IoTCListInsertNode(id, tg);
-    if(newChildNode == NULL){
-        return false;
-    }
-
-    return true;
-}
-
 /* 
 The 221 response is received if we dynamically added a child from the application.
 We're expecting a response in the form
@@ -839,7 +848,11 @@ static bool IoTCProcess221Response(JSON_Object *dProperties){
         }
 
         // The child was added on IoTConnect, now add it to the dynamic list of children on the device
-        IoTCListAddChild(idString, tagString);
+        if(IoTCListAddChild(idString, tagString) == NULL){
+            Log_Debug("[AVT IoTConnect] Unable to add GW Child id: %s to the list\n", idString);
+            dx_terminate(DX_ExitCode_Add_List_Node_Malloc_Failed);
+            return false;
+        }
 
         Log_Debug("[AVT IoTConnect] Add GW Child id: %s, tag: %s\n", idString, tagString);
     }
@@ -909,151 +922,291 @@ static bool IoTCProcess222Response(JSON_Object *dProperties){
     return true;
 }
 
-gw_child_list_node_t* IoTCListInsertNode(const char* id, const char* tg){
-
-    // Create the new node on the heap
-    gw_child_list_node_t* newNode = IoTCListGetNewNode(id, tg);
+static uint32_t IoTCHash(const char *text)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*text) {
+        hash ^= (uint8_t)*text++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
-    // Check to see if the list is empty
-    if(gwChildrenListHead == NULL){
+/// <summary>
+/// Returns the index slot holding id, or the empty slot where it would be inserted
+/// </summary>
+static size_t IoTCListFindSlot(const char *id, uint32_t hash)
+{
+    size_t mask = gwChildIndexSize - 1;
+    size_t slot = hash & mask;
 
-        gwChildrenListHead = newNode;
+    while (gwChildIndex[slot] != 0) {
+        gw_child_list_node_t *child = &gwChildren[gwChildIndex[slot] - 1];
+        if (child->__hash == hash && strcmp(child->id, id) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
     }
-    else{
 
-        // The list is not empty, find the last node in the list
-        gw_child_list_node_t* lastNodePtr = gwChildrenListHead;
-        while(lastNodePtr->next != NULL){
-            lastNodePtr = lastNodePtr->next;
-        } 
+    return slot;
+}
 
-        // We found the last node, add the new node to the end of the list    
-        lastNodePtr->next = newNode;
-        newNode->prev = lastNodePtr;    
+/// <summary>
+/// Rehash every child into an index of size slots, an index of the current size is cleared and reused so rebuilding
+/// after the list is compacted cannot fail
+/// </summary>
+static bool IoTCListRebuildIndex(size_t size)
+{
+    if (gwChildIndex != NULL && size == gwChildIndexSize) {
+        memset(gwChildIndex, 0x00, size * sizeof(size_t));
+    } else {
+        size_t *index = (size_t *)calloc(size, sizeof(size_t));
+        if (index == NULL) {
+            return false;
+        }
+
+        free(gwChildIndex);
+        gwChildIndex = index;
+        gwChildIndexSize = size;
     }
-    
-	return newNode;
+
+    for (size_t i = 0; i < gwChildCount; i++) {
+        gwChildIndex[IoTCListFindSlot(gwChildren[i].id, gwChildren[i].__hash)] = i + 1;
+    }
+
+    return true;
 }
 
-void IoTClistDelete(void){
+/// <summary>
+/// Make room for count children, keeping the index at most half full
+/// </summary>
+static bool IoTCListReserve(size_t count)
+{
+    if (count > gwChildCapacity) {
+        size_t capacity = gwChildCapacity ? gwChildCapacity : 16;
+        while (capacity < count) {
+            capacity <<= 1;
+        }
 
-    gw_child_list_node_t* currentNode = gwChildrenListHead;
-    gw_child_list_node_t* nextNodePtr = NULL;
-
-    // Traverse the list removing nodes as we go
-    while(currentNode != NULL){
-        
-        nextNodePtr = currentNode->next;
-        
-        // Free the memory from the heap
-        free(currentNode);
-        currentNode = nextNodePtr;
+        gw_child_list_node_t *children = (gw_child_list_node_t *)realloc(gwChildren, capacity * sizeof(gw_child_list_node_t));
+        if (children == NULL) {
+            return false;
+        }
+        gwChildren = children;
+        gwChildCapacity = capacity;
     }
 
-    // Reset the head pointer
-    gwChildrenListHead = NULL;
+    if (count * 2 > gwChildIndexSize) {
+        size_t size = gwChildIndexSize ? gwChildIndexSize : 32;
+        while (size < count * 2) {
+            size <<= 1;
+        }
+        return IoTCListRebuildIndex(size);
+    }
+
+    return true;
 }
 
-void dx_avnetPrintGwChildrenList(void){
+/// <summary>
+/// Rebuild the tag set from the tags the children still use, freeing tags that were left behind by removed children or
+/// tag updates. The new set is sized at most a quarter full so the next rebuild is amortised over the tags added before it.
+/// </summary>
+static bool IoTCTagsRebuild(void)
+{
+    size_t live = gwTagCount < gwChildCount ? gwTagCount : gwChildCount;
+    size_t size = 16;
+    size_t slot;
+    char **tags;
 
-    gw_child_list_node_t* currentNode = gwChildrenListHead;
-    uint8_t numChildren = 0;
+    while (size < (live + 1) * 4) {
+        size <<= 1;
+    }
 
-    // Traverse the list printing node details as we go
-    while(currentNode != NULL){
+    if ((tags = (char **)calloc(size, sizeof(char *))) == NULL) {
+        return false;
+    }
+
+    // Children point at interned strings, so pointer equality is string equality
+    live = 0;
+    for (size_t i = 0; i < gwChildCount; i++) {
+        char *tg = (char *)gwChildren[i].tg;
+
+        slot = IoTCHash(tg) & (size - 1);
+        while (tags[slot] != NULL && tags[slot] != tg) {
+            slot = (slot + 1) & (size - 1);
+        }
+        if (tags[slot] == NULL) {
+            tags[slot] = tg;
+            live++;
+        }
+    }
 
-        Log_Debug("Child node #%d, ID: %s, Tag: %s\n", ++numChildren, currentNode->id, currentNode->tg);
-        currentNode = currentNode->next;
+    for (size_t i = 0; i < gwTagIndexSize; i++) {
+        if (gwTags[i] != NULL) {
+            slot = IoTCHash(gwTags[i]) & (size - 1);
+            while (tags[slot] != NULL && tags[slot] != gwTags[i]) {
+                slot = (slot + 1) & (size - 1);
+            }
+            if (tags[slot] == NULL) {
+                free(gwTags[i]);
+            }
+        }
     }
+
+    free(gwTags);
+    gwTags = tags;
+    gwTagCount = live;
+    gwTagIndexSize = size;
+
+    return true;
 }
 
-bool IoTCListDeleteNodeById(const char* id){
+/// <summary>
+/// Returns the shared copy of tg, children with the same tag point at the same string
+/// </summary>
+static const char *IoTCInternTag(const char *tg)
+{
+    uint32_t hash = IoTCHash(tg);
+    size_t slot;
+
+    // Collect unused tags rather than growing, churning children would otherwise grow the set without bound
+    if ((gwTagCount + 1) * 2 > gwTagIndexSize && !IoTCTagsRebuild()) {
+        return NULL;
+    }
+
+    slot = hash & (gwTagIndexSize - 1);
+    while (gwTags[slot] != NULL) {
+        if (strcmp(gwTags[slot], tg) == 0) {
+            return gwTags[slot];
+        }
+        slot = (slot + 1) & (gwTagIndexSize - 1);
+    }
+
+    if ((gwTags[slot] = strdup(tg)) == NULL) {
+        return NULL;
+    }
+    gwTagCount++;
 
-    gw_child_list_node_t* nodePtr = IoTCListFindNodeById(id);
-    return IoTCListDeleteNode(nodePtr);
+    return gwTags[slot];
 }
 
-gw_child_list_node_t* IoTCListFindNodeById(const char* id){
+/// <summary>
+/// Add a child, or update the tag of an existing child with the same id
+/// </summary>
+static gw_child_list_node_t* IoTCListAddChild(const char* id, const char* tg){
 
-    // Check to see if the list is empty
-    if(gwChildrenListHead == NULL){
+    uint32_t hash = IoTCHash(id);
+    const char *internedTag;
+    size_t slot;
 
+    if(!IoTCListReserve(gwChildCount + 1) || (internedTag = IoTCInternTag(tg)) == NULL){
         return NULL;
     }
-    else{
 
-        // The list is not empty, traverse the list looking for the node 
-        gw_child_list_node_t* nodePtr = gwChildrenListHead;
-        while(nodePtr != NULL){
-            if(strncmp(nodePtr->id, id, DX_AVNET_IOT_CONNECT_GW_FIELD_LEN)==0){
-                return nodePtr;
-            }
-            nodePtr = nodePtr->next;
-        } 
+    slot = IoTCListFindSlot(id, hash);
+
+    if(gwChildIndex[slot] != 0){
+        gw_child_list_node_t *child = &gwChildren[gwChildIndex[slot] - 1];
+        child->tg = internedTag;
+        return child;
+    }
+
+    gw_child_list_node_t *child = &gwChildren[gwChildCount];
+    if((child->id = strdup(id)) == NULL){
+        return NULL;
+    }
+
+    child->tg = internedTag;
+    child->__hash = hash;
+    child->__present = false;
+
+    gwChildIndex[slot] = ++gwChildCount;
+
+    return child;
+}
+
+void IoTClistDelete(void){
+
+    for(size_t i = 0; i < gwChildCount; i++){
+        free(gwChildren[i].id);
     }
 
-    // We did not find the node, return NULL    
-	return NULL;
+    for(size_t i = 0; i < gwTagIndexSize; i++){
+        free(gwTags[i]);
+    }
+
+    free(gwChildren);
+    free(gwChildIndex);
+    free(gwTags);
+
+    gwChildren = NULL;
+    gwChildCount = gwChildCapacity = 0;
+    gwChildIndex = NULL;
+    gwChildIndexSize = 0;
+    gwTags = NULL;
+    gwTagCount = gwTagIndexSize = 0;
 }
 
-bool IoTCListDeleteNode(gw_child_list_node_t* nodeToRemove){
+void dx_avnetPrintGwChildrenList(void){
+
+    // Traverse the list printing node details as we go
+    for(size_t i = 0; i < gwChildCount; i++){
+
+        Log_Debug("Child node #%d, ID: %s, Tag: %s\n", (int)i + 1, gwChildren[i].id, gwChildren[i].tg);
+    }
+}
 
-    // If the node was not found, then return
-    if(nodeToRemove == NULL){
+static bool IoTCListDeleteNodeById(const char* id){
+
+    size_t mask = gwChildIndexSize - 1;
+    size_t hole, slot, removed, last;
+
+    if(gwChildCount == 0){
         return false;
     }
 
-    // First check to see if the node is the head
-    if(gwChildrenListHead == nodeToRemove){
+    hole = IoTCListFindSlot(id, IoTCHash(id));
+    if(gwChildIndex[hole] == 0){
+        return false;
+    }
 
-        // Check to see if there is a node after the head
-        if(nodeToRemove->next != NULL){
-            nodeToRemove->next->prev = NULL;
-            gwChildrenListHead = nodeToRemove->next;
-        }
-        // Else the list has one entry and it's the head node
-        else{
-            gwChildrenListHead = NULL;
-        }
+    removed = gwChildIndex[hole] - 1;
+    gwChildIndex[hole] = 0;
 
-        free(nodeToRemove);
-        return true;
+    // Backward shift deletion, move later entries of the probe run into the hole unless they would then sit before
+    // their home slot
+    for(slot = (hole + 1) & mask; gwChildIndex[slot] != 0; slot = (slot + 1) & mask){
+        size_t home = gwChildren[gwChildIndex[slot] - 1].__hash & mask;
+
+        if(((slot - home) & mask) >= ((slot - hole) & mask)){
+            gwChildIndex[hole] = gwChildIndex[slot];
+            gwChildIndex[slot] = 0;
+            hole = slot;
+        }
     }
 
-    // Check if the node to remove is at the end of the list
-    if(nodeToRemove->next == NULL){
+    free(gwChildren[removed].id);
 
-        nodeToRemove->prev->next = NULL;
-        free(nodeToRemove);
-        return true;
+    // Keep the array contiguous by moving the last child into the gap
+    last = --gwChildCount;
+    if(removed != last){
+        gwChildren[removed] = gwChildren[last];
+        gwChildIndex[IoTCListFindSlot(gwChildren[removed].id, gwChildren[removed].__hash)] = removed + 1;
     }
 
-    // Else the node is not at the head or tail
-    nodeToRemove->prev->next = nodeToRemove->next;
-    nodeToRemove->next->prev = nodeToRemove->prev;
-    free(nodeToRemove);
     return true;
 }
 
-//Creates a new Node and returns pointer to it, note the node is not inserted
-// into a list, it's simply created on the heap.
-gw_child_list_node_t* IoTCListGetNewNode(const char* id, const char* tg) {
+static gw_child_list_node_t* IoTCListFindNodeById(const char* id){
 
-	size_t nodeSize = sizeof(gw_child_list_node_t);
+    size_t slot;
 
-	gw_child_list_node_t* newNode = malloc(nodeSize);
-	memset(newNode, 0,  nodeSize);
+    if(gwChildCount == 0 || id == NULL){
+        return NULL;
+    }
 
-	// Verify we were able to allocate memory for the new node, if not
-	// then set exitCode to reflect the erro.  The main loop will see this
-	// change and exit.
-	if(newNode == NULL){
-		dx_terminate(DX_ExitCode_Add_List_Node_Malloc_Failed);
-	}
+    slot = IoTCListFindSlot(id, IoTCHash(id));
 
-	newNode->prev = NULL;
-	newNode->next = NULL;
-	strncpy(newNode->id, id, DX_AVNET_IOT_CONNECT_GW_FIELD_LEN);
-	strncpy(newNode->tg, tg, DX_AVNET_IOT_CONNECT_GW_FIELD_LEN);
-	return newNode;
-}
\ No newline at end of file
+    return gwChildIndex[slot] != 0 ? &gwChildren[gwChildIndex[slot] - 1] : NULL;
+}
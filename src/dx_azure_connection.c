@@ -0,0 +1,380 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#include "dx_azure_connection.h"
+
+#include "dx_utilities.h"
+#include "iothub.h"
+#include "iothub_client_options.h"
+#include "iothub_transport_ll.h"
+#include "iothubtransportamqp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <uv.h>
+
+struct _azureTransport {
+    TRANSPORT_HANDLE transportHandle;
+    DX_AZURE_CONNECTION *connections;
+    uv_timer_t doWorkTimer;
+    bool walking;        // in TransportDoWorkHandler, destroys are deferred until the walk is finished
+    bool destroyPending;
+};
+
+struct _azureConnection {
+    DX_AZURE_TRANSPORT *transport;
+    IOTHUB_DEVICE_CLIENT_LL_HANDLE clientHandle;
+    DX_AZURE_DEVICE_CONFIG config; // deviceId and deviceKey are owned copies
+    bool connected;
+    bool reportQueued;   // reported states wait in the client queue until this client's DoWork hands them to the transport
+    bool destroyPending; // destroyed from a callback during the DoWork walk, no further callbacks are delivered
+    struct _azureConnection *next;
+};
+
+typedef struct {
+    DX_PUBLISH_COMPLETE_HANDLER publishComplete;
+    void *context;
+} CONNECTION_PUBLISH_CONTEXT;
+
+static bool platformInitialized = false;
+
+static uint64_t PollPeriodMs(void)
+{
+    uint64_t period = (uint64_t)IOT_HUB_POLL_TIME_SECONDS * 1000 + (uint64_t)IOT_HUB_POLL_TIME_NANOSECONDS / 1000000;
+    return period > 0 ? period : 1;
+}
+
+/// <summary>
+///     Every client's DoWork also runs the shared AMQP transport DoWork, which services all registered devices, so calling
+///     it for each device made a poll period O(N^2). The only per-client work EdgeDevX relies on is moving queued reported
+///     states to the transport, so DoWork runs for the clients that have reported states queued, or else once on the first
+///     client to service the transport. Callbacks run inside DoWork and may destroy connections or the transport, those
+///     destroys are carried out once the walk is finished.
+/// </summary>
+static void TransportDoWorkHandler(uv_timer_t *handle)
+{
+    DX_AZURE_TRANSPORT *transport = (DX_AZURE_TRANSPORT *)handle->data;
+    DX_AZURE_CONNECTION *connection, *next, *first = NULL;
+    bool transportServiced = false;
+
+    transport->walking = true;
+
+    for (connection = transport->connections; connection != NULL && !transport->destroyPending; connection = next) {
+        next = connection->next;
+
+        if (connection->destroyPending) {
+            continue;
+        }
+
+        if (first == NULL) {
+            first = connection;
+        }
+
+        // the AMQP transport takes every queued reported state, so one DoWork empties the queue
+        if (connection->reportQueued) {
+            connection->reportQueued = false;
+            IoTHubDeviceClient_LL_DoWork(connection->clientHandle);
+            transportServiced = true;
+        }
+    }
+
+    if (!transportServiced && first != NULL && !first->destroyPending && !transport->destroyPending) {
+        IoTHubDeviceClient_LL_DoWork(first->clientHandle);
+    }
+
+    transport->walking = false;
+
+    if (transport->destroyPending) {
+        dx_azureTransportDestroy(transport);
+        return;
+    }
+
+    for (connection = transport->connections; connection != NULL; connection = next) {
+        next = connection->next;
+
+        if (connection->destroyPending) {
+            dx_azureConnectionDestroy(connection);
+        }
+    }
+}
+
+DX_AZURE_TRANSPORT *dx_azureTransportCreate(const char *iotHubName, const char *iotHubSuffix)
+{
+    DX_AZURE_TRANSPORT *transport;
+
+    if (dx_isStringNullOrEmpty(iotHubName) || dx_isStringNullOrEmpty(iotHubSuffix)) {
+        return NULL;
+    }
+
+    if (!platformInitialized) {
+        if (IoTHub_Init() != 0) {
+            dx_Log_Debug("ERROR: IoTHub_Init failed\n");
+            return NULL;
+        }
+        platformInitialized = true;
+    }
+
+    if ((transport = (DX_AZURE_TRANSPORT *)calloc(1, sizeof(DX_AZURE_TRANSPORT))) == NULL) {
+        return NULL;
+    }
+
+    if ((transport->transportHandle = IoTHubTransport_Create(AMQP_Protocol, iotHubName, iotHubSuffix)) == NULL) {
+        dx_Log_Debug("ERROR: Failed to create the shared IoT Hub transport\n");
+        free(transport);
+        return NULL;
+    }
+
+    uv_timer_init(uv_default_loop(), &transport->doWorkTimer);
+    transport->doWorkTimer.data = transport;
+
+    return transport;
+}
+
+static void TransportTimerClosed(uv_handle_t *handle)
+{
+    free(handle->data);
+}
+
+void dx_azureTransportDestroy(DX_AZURE_TRANSPORT *transport)
+{
+    if (transport == NULL) {
+        return;
+    }
+
+    if (transport->walking) {
+        transport->destroyPending = true;
+        return;
+    }
+
+    while (transport->connections != NULL) {
+        dx_azureConnectionDestroy(transport->connections);
+    }
+
+    IoTHubTransport_Destroy(transport->transportHandle);
+    transport->transportHandle = NULL;
+
+    uv_timer_stop(&transport->doWorkTimer);
+    uv_close((uv_handle_t *)&transport->doWorkTimer, TransportTimerClosed);
+}
+
+static void ConnectionStatusCallback(IOTHUB_CLIENT_CONNECTION_STATUS result, IOTHUB_CLIENT_CONNECTION_STATUS_REASON reason, void *userContextCallback)
+{
+    DX_AZURE_CONNECTION *connection = (DX_AZURE_CONNECTION *)userContextCallback;
+    bool connected = result == IOTHUB_CLIENT_CONNECTION_AUTHENTICATED;
+
+    if (connection->destroyPending) {
+        return;
+    }
+
+    if (connected != connection->connected) {
+        connection->connected = connected;
+
+        if (connection->config.connectionChanged != NULL) {
+            connection->config.connectionChanged(connection, connected, connection->config.context);
+        }
+    }
+}
+
+static IOTHUBMESSAGE_DISPOSITION_RESULT MessageReceivedCallback(IOTHUB_MESSAGE_HANDLE message, void *userContextCallback)
+{
+    DX_AZURE_CONNECTION *connection = (DX_AZURE_CONNECTION *)userContextCallback;
+
+    if (connection->destroyPending) {
+        return IOTHUBMESSAGE_ABANDONED;
+    }
+
+    if (connection->config.messageReceived != NULL) {
+        return connection->config.messageReceived(connection, message, connection->config.context);
+    }
+
+    return IOTHUBMESSAGE_ACCEPTED;
+}
+
+static void DeviceTwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned char *payload, size_t payloadSize, void *userContextCallback)
+{
+    DX_AZURE_CONNECTION *connection = (DX_AZURE_CONNECTION *)userContextCallback;
+
+    if (connection->config.deviceTwinChanged != NULL && !connection->destroyPending) {
+        connection->config.deviceTwinChanged(connection, updateState, payload, payloadSize, connection->config.context);
+    }
+}
+
+static int DirectMethodCallback(const char *method_name, const unsigned char *payload, size_t payloadSize, unsigned char **responsePayload,
+                                size_t *responsePayloadSize, void *userContextCallback)
+{
+    static const char methodNotFoundMsg[] = "\"Method not found\"";
+    DX_AZURE_CONNECTION *connection = (DX_AZURE_CONNECTION *)userContextCallback;
+
+    if (connection->config.directMethod != NULL && !connection->destroyPending) {
+        return connection->config.directMethod(connection, method_name, payload, payloadSize, responsePayload, responsePayloadSize,
+                                               connection->config.context);
+    }
+
+    // the SDK frees the response
+    if ((*responsePayload = (unsigned char *)malloc(sizeof(methodNotFoundMsg) - 1)) != NULL) {
+        memcpy(*responsePayload, methodNotFoundMsg, sizeof(methodNotFoundMsg) - 1);
+        *responsePayloadSize = sizeof(methodNotFoundMsg) - 1;
+    }
+
+    return 404;
+}
+
+DX_AZURE_CONNECTION *dx_azureConnectionCreate(DX_AZURE_TRANSPORT *transport, const DX_AZURE_DEVICE_CONFIG *config)
+{
+    IOTHUB_CLIENT_DEVICE_CONFIG deviceConfig = {0};
+    DX_AZURE_CONNECTION *connection;
+    bool urlAutoEncodeDecode = true;
+
+    if (transport == NULL || config == NULL || dx_isStringNullOrEmpty(config->deviceId) || dx_isStringNullOrEmpty(config->deviceKey)) {
+        return NULL;
+    }
+
+    if ((connection = (DX_AZURE_CONNECTION *)calloc(1, sizeof(DX_AZURE_CONNECTION))) == NULL) {
+        return NULL;
+    }
+
+    connection->transport = transport;
+    connection->config = *config;
+    connection->config.deviceId = strdup(config->deviceId);
+    connection->config.deviceKey = strdup(config->deviceKey);
+
+    if (connection->config.deviceId == NULL || connection->config.deviceKey == NULL) {
+        goto error;
+    }
+
+    deviceConfig.protocol = AMQP_Protocol;
+    deviceConfig.transportHandle = IoTHubTransport_GetLLTransport(transport->transportHandle);
+    deviceConfig.deviceId = connection->config.deviceId;
+    deviceConfig.deviceKey = connection->config.deviceKey;
+
+    if ((connection->clientHandle = IoTHubDeviceClient_LL_CreateWithTransport(&deviceConfig)) == NULL) {
+        dx_Log_Debug("ERROR: Failed to register device %s on the shared IoT Hub transport\n", config->deviceId);
+        goto error;
+    }
+
+    (void)IoTHubDeviceClient_LL_SetOption(connection->clientHandle, OPTION_AUTO_URL_ENCODE_DECODE, &urlAutoEncodeDecode);
+
+    // the connection is the context for every callback so twins, methods and C2D messages route to their own device
+    IoTHubDeviceClient_LL_SetConnectionStatusCallback(connection->clientHandle, ConnectionStatusCallback, connection);
+    IoTHubDeviceClient_LL_SetMessageCallback(connection->clientHandle, MessageReceivedCallback, connection);
+    IoTHubDeviceClient_LL_SetDeviceTwinCallback(connection->clientHandle, DeviceTwinCallback, connection);
+    IoTHubDeviceClient_LL_SetDeviceMethodCallback(connection->clientHandle, DirectMethodCallback, connection);
+
+    connection->next = transport->connections;
+    transport->connections = connection;
+
+    if (!uv_is_active((uv_handle_t *)&transport->doWorkTimer)) {
+        uv_timer_start(&transport->doWorkTimer, TransportDoWorkHandler, 0, PollPeriodMs());
+    }
+
+    return connection;
+
+error:
+    free((char *)connection->config.deviceId);
+    free((char *)connection->config.deviceKey);
+    free(connection);
+    return NULL;
+}
+
+void dx_azureConnectionDestroy(DX_AZURE_CONNECTION *connection)
+{
+    DX_AZURE_TRANSPORT *transport;
+
+    if (connection == NULL) {
+        return;
+    }
+
+    transport = connection->transport;
+
+    if (transport->walking) {
+        connection->destroyPending = true;
+        return;
+    }
+
+    for (DX_AZURE_CONNECTION **link = &transport->connections; *link != NULL; link = &(*link)->next) {
+        if (*link == connection) {
+            *link = connection->next;
+            break;
+        }
+    }
+
+    // unregisters the device, the shared transport stays open for the remaining devices
+    IoTHubDeviceClient_LL_Destroy(connection->clientHandle);
+
+    if (transport->connections == NULL) {
+        uv_timer_stop(&transport->doWorkTimer);
+    }
+
+    free((char *)connection->config.deviceId);
+    free((char *)connection->config.deviceKey);
+    free(connection);
+}
+
+bool dx_azureConnectionIsConnected(DX_AZURE_CONNECTION *connection)
+{
+    return connection != NULL && connection->connected && !connection->destroyPending;
+}
+
+const char *dx_azureConnectionDeviceId(DX_AZURE_CONNECTION *connection)
+{
+    return connection != NULL ? connection->config.deviceId : NULL;
+}
+
+static void PublishCompleteCallback(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void *userContextCallback)
+{
+    CONNECTION_PUBLISH_CONTEXT *publishContext = (CONNECTION_PUBLISH_CONTEXT *)userContextCallback;
+
+    publishContext->publishComplete(result == IOTHUB_CLIENT_CONFIRMATION_OK, publishContext->context);
+    free(publishContext);
+}
+
+bool dx_azureConnectionPublish(DX_AZURE_CONNECTION *connection, const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties,
+                               size_t messagePropertyCount, DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties,
+                               DX_PUBLISH_COMPLETE_HANDLER publishComplete, void *context)
+{
+    CONNECTION_PUBLISH_CONTEXT *publishContext = NULL;
+    IOTHUB_MESSAGE_HANDLE messageHandle;
+    IOTHUB_CLIENT_RESULT result;
+
+    if (!dx_azureConnectionIsConnected(connection)) {
+        return false;
+    }
+
+    if (publishComplete != NULL) {
+        if ((publishContext = (CONNECTION_PUBLISH_CONTEXT *)malloc(sizeof(CONNECTION_PUBLISH_CONTEXT))) == NULL) {
+            return false;
+        }
+        publishContext->publishComplete = publishComplete;
+        publishContext->context = context;
+    }
+
+    if ((messageHandle = dx_azureCreateMessage(message, messageLength, messageProperties, messagePropertyCount, messageContentProperties)) == NULL) {
+        free(publishContext);
+        return false;
+    }
+
+    result = IoTHubDeviceClient_LL_SendEventAsync(connection->clientHandle, messageHandle, publishContext != NULL ? PublishCompleteCallback : NULL,
+                                                  publishContext);
+    IoTHubMessage_Destroy(messageHandle);
+
+    if (result != IOTHUB_CLIENT_OK) {
+        dx_Log_Debug("ERROR: failed to hand over the message for %s to IoTHubClient\n", connection->config.deviceId);
+        free(publishContext);
+        return false;
+    }
+
+    return true;
+}
+
+bool dx_azureConnectionReportState(DX_AZURE_CONNECTION *connection, const unsigned char *reportedState, size_t reportedStateLength)
+{
+    if (!dx_azureConnectionIsConnected(connection) || reportedState == NULL || reportedStateLength == 0) {
+        return false;
+    }
+
+    if (IoTHubDeviceClient_LL_SendReportedState(connection->clientHandle, reportedState, reportedStateLength, NULL, NULL) != IOTHUB_CLIENT_OK) {
+        return false;
+    }
+
+    connection->reportQueued = true;
+    return true;
+}
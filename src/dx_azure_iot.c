@@ -6,11 +6,14 @@
 #include "azure_prov_client/prov_device_ll_client.h"
 #include "azure_prov_client/prov_security_factory.h"
 #include "azure_prov_client/prov_transport_mqtt_client.h"
+#include "dx_telemetry_spool.h"
 #include "dx_timer.h"
 #include "dx_utilities.h"
 #include "iothub.h"
 #include "iothub_client_options.h"
 #include "iothubtransportmqtt.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/socketio.h"
 
 #define MAX_CONNECTION_STATUS_CALLBACKS 5
 
@@ -21,8 +24,11 @@ static bool SetupAzureClient(void);
 static const char *GetMessageResultReasonString(IOTHUB_MESSAGE_RESULT reason);
 static const char *GetReasonString(IOTHUB_CLIENT_CONNECTION_STATUS_REASON reason);
 static DX_DECLARE_TIMER_HANDLER(AzureConnectionHandler);
+static DX_DECLARE_TIMER_HANDLER(PublishFlushHandler);
 static void HubConnectionStatusCallback(IOTHUB_CLIENT_CONNECTION_STATUS, IOTHUB_CLIENT_CONNECTION_STATUS_REASON, void *);
 static void SendMessageCallback(IOTHUB_CLIENT_CONFIRMATION_RESULT, void *);
+static void SocketWatchChanged(void *context, int socket, int send_pending);
+static void NetworkReachabilityChanged(bool connected);
 
 static bool network_ready_cached = false;
 static DX_DECLARE_TIMER_HANDLER(network_ready_expired_handler);
@@ -34,8 +40,30 @@ static char *iotHubUri = NULL;
 static const char *_networkInterface = NULL;
 static DX_USER_CONFIG *_userConfig = NULL;
 static int outstandingMessageCount = 0;
+static size_t publishWindowHigh = 0;
+static size_t publishWindowLow = 0;
+static bool publishWindowOpen = true;
+static void (*_publishWindowCallback)(bool open) = NULL;
 static bool connection_initialized = false;
 
+static bool eventDrivenDoWork = false;
+static uv_poll_t *socketPoll = NULL;
+static int socketPollFd = -1;
+static const SOCKETIO_WATCH socketWatch = {.on_watch_changed = SocketWatchChanged, .context = NULL};
+
+typedef struct DX_STAGED_MESSAGE {
+    IOTHUB_MESSAGE_HANDLE messageHandle;
+    DX_PUBLISH_COMPLETE_HANDLER publishComplete;
+    void *context;
+    struct DX_STAGED_MESSAGE *next;
+} DX_STAGED_MESSAGE;
+
+static DX_STAGED_MESSAGE *stagedHead = NULL;
+static DX_STAGED_MESSAGE *stagedTail = NULL;
+static void CompleteStagedMessage(DX_STAGED_MESSAGE *staged, bool delivered);
+static void DiscardStagedMessages(void);
+static void UpdatePublishWindow(void);
+
 static char *_pnpModelIdJson = NULL;
 static const char *_pnpModelId = NULL;
 static const char *_pnpModelIdJsonTemplate = "{\"modelId\":\"%s\"}";
@@ -78,6 +106,7 @@ static IoTHubClientAuthenticationState iotHubClientAuthenticationState = IoTHubC
 static PROV_DEVICE_RESULT dpsRegisterStatus = PROV_DEVICE_RESULT_INVALID_STATE;
 
 static DX_TIMER_BINDING azureConnectionTimer = {.delay = &(struct timespec){1, 0}, .name = "azureConnectionTimer", .handler = &AzureConnectionHandler};
+static DX_TIMER_BINDING publishFlushTimer = {.name = "publishFlushTimer", .handler = &PublishFlushHandler};
 
 IOTHUB_DEVICE_CLIENT_LL_HANDLE * dx_azureRegisterDeviceTwinCallback(void (*deviceTwinCallbackHandler)(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned char *payload, size_t payloadSize,
                                                                           void *userContextCallback))
@@ -130,16 +159,82 @@ static void dx_azureToDeviceStart(void)
             return;
         }
         dx_timerStart(&azureConnectionTimer);
+        dx_timerStart(&publishFlushTimer);
         dx_timerStart(&tmr_network_ready_cached);
+        dx_setNetworkReachabilityCallback(NetworkReachabilityChanged);
         connection_initialized = false;
     }
 }
 
+static void SocketPollCloseHandler(uv_handle_t *handle)
+{
+    free(handle);
+}
+
+static void StopSocketPoll(void)
+{
+    if (socketPoll != NULL) {
+        uv_poll_stop(socketPoll);
+        uv_close((uv_handle_t *)socketPoll, SocketPollCloseHandler);
+        socketPoll = NULL;
+    }
+    socketPollFd = -1;
+}
+
+/// <summary>
+/// IoT Hub socket is readable or has queued data that can now be written
+/// </summary>
+static void SocketPollHandler(uv_poll_t *handle, int status, int events)
+{
+    if (iothubClientHandle != NULL) {
+        IoTHubDeviceClient_LL_DoWork(iothubClientHandle);
+    }
+}
+
+/// <summary>
+/// Called by the socket layer when the IoT Hub socket is opened, closed, or its pending send state changes.
+/// Note, this is called from within DoWork, the poll handle may be closed from its own callback which libuv permits.
+/// </summary>
+static void SocketWatchChanged(void *context, int socket, int send_pending)
+{
+    if (socket != socketPollFd) {
+        StopSocketPoll();
+
+        if (socket < 0) {
+            return;
+        }
+
+        if ((socketPoll = (uv_poll_t *)malloc(sizeof(uv_poll_t))) == NULL) {
+            return;
+        }
+
+        if (uv_poll_init_socket(uv_default_loop(), socketPoll, socket) != 0) {
+            dx_Log_Debug("ERROR: Unable to watch IoT Hub socket, falling back to polling\n");
+            free(socketPoll);
+            socketPoll = NULL;
+            return;
+        }
+
+        socketPollFd = socket;
+    }
+
+    uv_poll_start(socketPoll, send_pending ? UV_READABLE | UV_WRITABLE : UV_READABLE, SocketPollHandler);
+}
+
+void dx_azureSetEventDrivenDoWork(bool enabled)
+{
+    eventDrivenDoWork = enabled;
+}
+
 void dx_azureToDeviceStop(void)
 {
     if (azureConnectionTimer.initialized) {
+        StopSocketPoll();
         dx_timerStop(&azureConnectionTimer);
+        dx_timerStop(&publishFlushTimer);
+        DiscardStagedMessages();
         dx_timerStop(&tmr_network_ready_cached);
+        dx_setNetworkReachabilityCallback(NULL);
         IoTHub_Deinit();
     }
 }
@@ -231,6 +326,12 @@ static DX_TIMER_HANDLER(network_ready_expired_handler)
 }
 DX_TIMER_HANDLER_END
 
+static void NetworkReachabilityChanged(bool connected)
+{
+    // drop the cached state so the connection timer picks up the probe result on its next tick
+    network_ready_cached = false;
+}
+
 static bool isNetworkReady(const char* network_interface){
     static bool connection_state = false;
 
@@ -259,6 +360,48 @@ bool dx_isAzureConnected(void)
     return false;
 }
 
+/// <summary>
+///     Close the publish window at the high watermark, reopen it once outstanding messages drain to the low watermark
+/// </summary>
+static void UpdatePublishWindow(void)
+{
+    bool open = publishWindowOpen;
+    size_t outstanding = dx_azureGetOutstandingCount();
+
+    if (publishWindowHigh == 0) {
+        open = true;
+    } else if (publishWindowOpen && outstanding >= publishWindowHigh) {
+        open = false;
+    } else if (!publishWindowOpen && outstanding <= publishWindowLow) {
+        open = true;
+    }
+
+    if (open != publishWindowOpen) {
+        publishWindowOpen = open;
+        if (_publishWindowCallback != NULL) {
+            _publishWindowCallback(open);
+        }
+    }
+}
+
+void dx_azureSetPublishWindow(size_t highWatermark, size_t lowWatermark, void (*publishWindowCallback)(bool open))
+{
+    publishWindowHigh = highWatermark;
+    publishWindowLow = lowWatermark < highWatermark ? lowWatermark : (highWatermark > 0 ? highWatermark - 1 : 0);
+    _publishWindowCallback = publishWindowCallback;
+    UpdatePublishWindow();
+}
+
+size_t dx_azureGetOutstandingCount(void)
+{
+    return outstandingMessageCount > 0 ? (size_t)outstandingMessageCount : 0;
+}
+
+bool dx_azureIsPublishWindowOpen(void)
+{
+    return publishWindowOpen;
+}
+
 /// <summary>
 ///     Callback confirming message delivered to IoT Hub.
 /// </summary>
@@ -267,9 +410,15 @@ bool dx_isAzureConnected(void)
 static void SendMessageCallback(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void *context)
 {
     outstandingMessageCount--;
+    UpdatePublishWindow();
 #if DX_LOGGING_ENABLED
     Log_Debug("INFO: Message received by IoT Hub. Result is: %d\n", result);
 #endif
+
+    // context is set for staged messages only
+    if (context != NULL) {
+        CompleteStagedMessage((DX_STAGED_MESSAGE *)context, result == IOTHUB_CLIENT_CONFIRMATION_OK);
+    }
 }
 
 /// <summary>
@@ -296,7 +445,12 @@ static DX_TIMER_HANDLER(AzureConnectionHandler)
         break;
     case IoTHubClientAuthenticationState_Authenticated:
         IoTHubDeviceClient_LL_DoWork(iothubClientHandle);
-        nextEventPeriod = (struct timespec){IOT_HUB_POLL_TIME_SECONDS, IOT_HUB_POLL_TIME_NANOSECONDS};
+        // socket events drive DoWork when the socket is being watched, the timer only covers keepalive and retries
+        if (socketPoll != NULL) {
+            nextEventPeriod = (struct timespec){IOT_HUB_HOUSEKEEPING_TIME_SECONDS, 0};
+        } else {
+            nextEventPeriod = (struct timespec){IOT_HUB_POLL_TIME_SECONDS, IOT_HUB_POLL_TIME_NANOSECONDS};
+        }
         break;
     case IoTHubClientAuthenticationState_Device_Disbled:
         iotHubClientAuthenticationState = IoTHubClientAuthenticationState_NotAuthenticated;
@@ -309,27 +463,20 @@ static DX_TIMER_HANDLER(AzureConnectionHandler)
 }
 DX_TIMER_HANDLER_END
 
-bool dx_azurePublish(const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties, size_t messagePropertyCount,
-                     DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties)
+/// <summary>
+///     Creates an IoT Hub message with optional application and content properties
+/// </summary>
+IOTHUB_MESSAGE_HANDLE dx_azureCreateMessage(const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties, size_t messagePropertyCount,
+                                            DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties)
 {
-    IOTHUB_CLIENT_RESULT result;
     IOTHUB_MESSAGE_RESULT messageResult;
     IOTHUB_MESSAGE_HANDLE messageHandle;
 
-    if (messageLength == 0) {
-        return true;
-    }
-
-    if (!dx_isAzureConnected()) {
-        // Log_Debug("FAILED: Not connected to Azure IoT\n");
-        return false;
-    }
-
     messageHandle = IoTHubMessage_CreateFromByteArray(message, messageLength);
 
     if (messageHandle == NULL) {
         dx_Log_Debug("ERROR: unable to create a new IoTHubMessage\n");
-        return false;
+        return NULL;
     }
 
     // add system content properties
@@ -362,16 +509,45 @@ bool dx_azurePublish(const void *message, size_t messageLength, DX_MESSAGE_PROPE
         }
     }
 
-    if ((result = IoTHubDeviceClient_LL_SendEventAsync(iothubClientHandle, messageHandle, SendMessageCallback,
-                                                       /*&callback_param*/ 0)) != IOTHUB_CLIENT_OK) {
-        dx_Log_Debug("ERROR: failed to hand over the message to IoTHubClient\n");
-    } else {
-        outstandingMessageCount++;
-    }
+    return messageHandle;
 
 cleanup:
+    IoTHubMessage_Destroy(messageHandle);
+    return NULL;
+}
+
+bool dx_azurePublish(const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties, size_t messagePropertyCount,
+                     DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties)
+{
+    IOTHUB_CLIENT_RESULT result = IOTHUB_CLIENT_ERROR;
+    IOTHUB_MESSAGE_HANDLE messageHandle;
+
+    if (messageLength == 0) {
+        return true;
+    }
+
+    if (!dx_isAzureConnected()) {
+        // store and forward when the telemetry spool is open
+        if (dx_telemetrySpoolIsOpen()) {
+            return dx_telemetrySpoolAppend(message, messageLength, messageProperties, messagePropertyCount, messageContentProperties);
+        }
+        // Log_Debug("FAILED: Not connected to Azure IoT\n");
+        return false;
+    }
+
+    if (!publishWindowOpen) {
+        return false;
+    }
+
+    if ((messageHandle = dx_azureCreateMessage(message, messageLength, messageProperties, messagePropertyCount, messageContentProperties)) != NULL) {
+        if ((result = IoTHubDeviceClient_LL_SendEventAsync(iothubClientHandle, messageHandle, SendMessageCallback,
+                                                           /*&callback_param*/ 0)) != IOTHUB_CLIENT_OK) {
+            dx_Log_Debug("ERROR: failed to hand over the message to IoTHubClient\n");
+        } else {
+            outstandingMessageCount++;
+            UpdatePublishWindow();
+        }
 
-    if (messageHandle != NULL) {
         IoTHubMessage_Destroy(messageHandle);
     }
 
@@ -380,6 +556,122 @@ cleanup:
     return result == IOTHUB_CLIENT_OK;
 }
 
+static void CompleteStagedMessage(DX_STAGED_MESSAGE *staged, bool delivered)
+{
+    if (staged->publishComplete != NULL) {
+        staged->publishComplete(delivered, staged->context);
+    }
+    free(staged);
+}
+
+static void DiscardStagedMessages(void)
+{
+    while (stagedHead != NULL) {
+        DX_STAGED_MESSAGE *next = stagedHead->next;
+        IoTHubMessage_Destroy(stagedHead->messageHandle);
+        outstandingMessageCount--;
+        CompleteStagedMessage(stagedHead, false);
+        stagedHead = next;
+    }
+    stagedTail = NULL;
+    UpdatePublishWindow();
+}
+
+/// <summary>
+///     Hands all staged messages to the IoT Hub client then flushes them with a single DoWork
+/// </summary>
+static DX_TIMER_HANDLER(PublishFlushHandler)
+{
+    DX_STAGED_MESSAGE *staged = stagedHead;
+    bool connected = dx_isAzureConnected();
+    bool sent = false;
+
+    stagedHead = stagedTail = NULL;
+
+    while (staged != NULL) {
+        DX_STAGED_MESSAGE *next = staged->next;
+        IOTHUB_MESSAGE_HANDLE messageHandle = staged->messageHandle;
+
+        staged->messageHandle = NULL;
+        staged->next = NULL;
+
+        if (connected && IoTHubDeviceClient_LL_SendEventAsync(iothubClientHandle, messageHandle, SendMessageCallback, staged) == IOTHUB_CLIENT_OK) {
+            // ownership of staged passes to SendMessageCallback, already counted as outstanding when staged
+            sent = true;
+        } else {
+            outstandingMessageCount--;
+            CompleteStagedMessage(staged, false);
+        }
+
+        IoTHubMessage_Destroy(messageHandle);
+        staged = next;
+    }
+
+    UpdatePublishWindow();
+
+    if (sent) {
+        IoTHubDeviceClient_LL_DoWork(iothubClientHandle);
+    }
+}
+DX_TIMER_HANDLER_END
+
+bool dx_azurePublishStaged(const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties, size_t messagePropertyCount,
+                           DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties, DX_PUBLISH_COMPLETE_HANDLER publishComplete, void *context)
+{
+    DX_STAGED_MESSAGE *staged = NULL;
+
+    if (messageLength == 0 || !publishFlushTimer.initialized) {
+        return false;
+    }
+
+    if (!dx_isAzureConnected() || !publishWindowOpen) {
+        return false;
+    }
+
+    if ((staged = (DX_STAGED_MESSAGE *)malloc(sizeof(DX_STAGED_MESSAGE))) == NULL) {
+        return false;
+    }
+
+    if ((staged->messageHandle = dx_azureCreateMessage(message, messageLength, messageProperties, messagePropertyCount, messageContentProperties)) == NULL) {
+        free(staged);
+        return false;
+    }
+
+    staged->publishComplete = publishComplete;
+    staged->context = context;
+    staged->next = NULL;
+
+    // staged messages count against the publish window so the window bounds memory, not just the SDK send queue
+    outstandingMessageCount++;
+    UpdatePublishWindow();
+
+    if (stagedTail == NULL) {
+        stagedHead = stagedTail = staged;
+        // first staged message since the last flush, flush on the next loop iteration
+        dx_timerOneShotSet(&publishFlushTimer, &(struct timespec){0, 0});
+    } else {
+        stagedTail->next = staged;
+        stagedTail = staged;
+    }
+
+    return true;
+}
+
+size_t dx_azurePublishBatch(DX_PUBLISH_ITEM *items, size_t itemCount, DX_PUBLISH_COMPLETE_HANDLER publishComplete)
+{
+    size_t staged = 0;
+
+    for (size_t i = 0; i < itemCount; i++) {
+        if (!dx_azurePublishStaged(items[i].message, items[i].messageLength, items[i].messageProperties, items[i].messagePropertyCount,
+                                   items[i].messageContentProperties, publishComplete, items[i].context)) {
+            break;
+        }
+        staged++;
+    }
+
+    return staged;
+}
+
 static IOTHUBMESSAGE_DISPOSITION_RESULT HubMessageReceivedCallback(IOTHUB_MESSAGE_HANDLE message, void *context)
 {
     if (_messageReceivedCallback != NULL) {
@@ -451,6 +743,10 @@ static bool SetupAzureClient()
     IoTHubDeviceClient_LL_SetConnectionStatusCallback(iothubClientHandle, HubConnectionStatusCallback, NULL);
     IoTHubDeviceClient_LL_SetMessageCallback(iothubClientHandle, HubMessageReceivedCallback, NULL);
 
+    if (eventDrivenDoWork && IoTHubDeviceClient_LL_SetOption(iothubClientHandle, OPTION_SOCKET_WATCH, &socketWatch) != IOTHUB_CLIENT_OK) {
+        dx_Log_Debug("Socket watch not supported by the transport, falling back to polling\n");
+    }
+
     IoTHubDeviceClient_LL_DoWork(iothubClientHandle);
 
     return true;
@@ -687,6 +983,7 @@ static void HubConnectionStatusCallback(IOTHUB_CLIENT_CONNECTION_STATUS result,
         deviceConnectionState = DEVICE_NOT_CONNECTED;
     } else {
         iotHubClientAuthenticationState = IoTHubClientAuthenticationState_Authenticated;
+        dx_telemetrySpoolResume();
     }
 
     dx_isAzureConnected();
@@ -4,8 +4,11 @@
 #include "dx_device_twins.h"
 
 #include "dx_azure_iot.h"
+#include "dx_name_index.h"
 #include "dx_terminate.h"
+#include "dx_timer.h"
 #include "parson.h"
+#include <stdint.h>
 #include <stdlib.h>
 
 
@@ -13,18 +16,55 @@ static bool deviceTwinReportState(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, voi
                                   bool deviceTwinPnPAcknowledgment,
                                   DX_DEVICE_TWIN_RESPONSE_CODE statusCode);
 static bool deviceTwinUpdateReportedState(char *reportedPropertiesString);
+static bool deviceTwinQueueReport(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, char *fragment);
+static void deviceTwinFlushReports(void);
+static void deviceTwinArmReportFlush(void);
 static void deviceTwinClose(DX_DEVICE_TWIN_BINDING *deviceTwinBinding);
 static void deviceTwinOpen(DX_DEVICE_TWIN_BINDING *deviceTwinBinding);
 static void deviceTwinsReportStatusCallback(int result, void *context);
-static void SetDesiredState(JSON_Object *desiredProperties,
-                            DX_DEVICE_TWIN_BINDING *deviceTwinBinding);
+static void SetDesiredState(JSON_Value *desiredValue, int version, DX_DEVICE_TWIN_BINDING *deviceTwinBinding);
 static void DeviceTwinCallbackHandler(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned char *payload, size_t payloadSize,
                                       void *userContextCallback);
+static DX_DECLARE_TIMER_HANDLER(ReportFlushHandler);
 
 static DX_DEVICE_TWIN_BINDING **_deviceTwins = NULL;
 static size_t _deviceTwinCount = 0;
 static IOTHUB_DEVICE_CLIENT_LL_HANDLE *_iothubClientHandle;
 
+// Property name index built at subscribe time, bindings that share a property name are chained from the same slot
+static DX_NAME_INDEX _twinIndex;
+
+// Report batching, one pending "name":value fragment per property name keyed by the index entry of the first binding with that name
+typedef struct {
+    size_t count;
+    size_t entries[]; // binding index + 1 of each property in the patch
+} DX_REPORT_BATCH;
+
+static char **_pendingReports = NULL;
+static size_t _pendingReportCount = 0;
+static size_t _pendingReportBytes = 0;
+static unsigned int _reportFlushIntervalMs = 0;
+static size_t _reportMaxPatchBytes = 0;
+static void (*_reportCompleteHandler)(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, bool delivered) = NULL;
+static DX_TIMER_BINDING reportFlushTimer = {.name = "reportFlushTimer", .handler = &ReportFlushHandler};
+
+// twin payloads are not null terminated, reuse one buffer for parsing rather than allocating per update
+static char *_payloadBuffer = NULL;
+static size_t _payloadBufferSize = 0;
+
+static const char *twinBindingName(size_t item, void *context)
+{
+    return _deviceTwins[item]->propertyName;
+}
+
+/// <summary>
+///     Returns binding index + 1 of the first binding for the property name, or 0 if not found
+/// </summary>
+static size_t twinIndexFind(const char *propertyName)
+{
+    return dx_nameIndexFind(&_twinIndex, propertyName, twinBindingName, NULL);
+}
+
 void dx_deviceTwinSubscribe(DX_DEVICE_TWIN_BINDING *deviceTwins[], size_t deviceTwinCount)
 {
     _iothubClientHandle = dx_azureRegisterDeviceTwinCallback(DeviceTwinCallbackHandler);
@@ -34,6 +74,21 @@ void dx_deviceTwinSubscribe(DX_DEVICE_TWIN_BINDING *deviceTwins[], size_t device
     for (int i = 0; i < _deviceTwinCount; i++) {
         deviceTwinOpen(_deviceTwins[i]);
     }
+
+    if (!dx_nameIndexBuild(&_twinIndex, _deviceTwinCount, twinBindingName, NULL, true)) {
+        printf("ERROR: Unable to build the device twin index\n");
+        dx_terminate(DX_ExitCode_OpenDeviceTwin);
+    }
+
+    if ((_pendingReports = (char **)calloc(_deviceTwinCount, sizeof(char *))) == NULL) {
+        dx_terminate(DX_ExitCode_OpenDeviceTwin);
+    }
+    _pendingReportCount = 0;
+    _pendingReportBytes = 0;
+
+    if (_reportFlushIntervalMs != 0) {
+        dx_timerStart(&reportFlushTimer);
+    }
 }
 
 void dx_deviceTwinUnsubscribe(void)
@@ -43,6 +98,34 @@ void dx_deviceTwinUnsubscribe(void)
     for (int i = 0; i < _deviceTwinCount; i++) {
         deviceTwinClose(_deviceTwins[i]);
     }
+
+    if (reportFlushTimer.initialized) {
+        dx_timerStop(&reportFlushTimer);
+    }
+
+    // pending reports are dropped, the last reported values are resent on the next report
+    if (_pendingReports != NULL) {
+        for (size_t i = 0; i < _deviceTwinCount; i++) {
+            if (_pendingReports[i] != NULL) {
+                if (_reportCompleteHandler != NULL) {
+                    _reportCompleteHandler(_deviceTwins[i], false);
+                }
+                free(_pendingReports[i]);
+            }
+        }
+        free(_pendingReports);
+        _pendingReports = NULL;
+        _pendingReportCount = 0;
+        _pendingReportBytes = 0;
+    }
+
+    dx_nameIndexFree(&_twinIndex);
+
+    if (_payloadBuffer != NULL) {
+        free(_payloadBuffer);
+        _payloadBuffer = NULL;
+        _payloadBufferSize = 0;
+    }
 }
 
 static void deviceTwinOpen(DX_DEVICE_TWIN_BINDING *deviceTwinBinding)
@@ -98,6 +181,7 @@ static void deviceTwinClose(DX_DEVICE_TWIN_BINDING *deviceTwinBinding)
 
 /// <summary>
 ///     Callback invoked when a Device Twin update is received from IoT Hub.
+///     The desired properties are walked once and each property is dispatched through the name index.
 /// </summary>
 /// <param name="payload">contains the Device Twin JSON document (desired and reported)</param>
 /// <param name="payloadSize">size of the Device Twin JSON document</param>
@@ -107,18 +191,21 @@ static void DeviceTwinCallbackHandler(DEVICE_TWIN_UPDATE_STATE updateState,
 {
     JSON_Value *root_value = NULL;
     JSON_Object *root_object = NULL;
+    int version = -1;
 
-    char *payLoadString = (char *)malloc(payloadSize + 1);
-    if (payLoadString == NULL) {
-        goto cleanup;
+    if (payloadSize + 1 > _payloadBufferSize) {
+        char *buffer = (char *)realloc(_payloadBuffer, payloadSize + 1);
+        if (buffer == NULL) {
+            return;
+        }
+        _payloadBuffer = buffer;
+        _payloadBufferSize = payloadSize + 1;
     }
 
-    memset(payLoadString, 0x00, payloadSize + 1);
-
-    memcpy(payLoadString, payload, payloadSize);
-    payLoadString[payloadSize] = 0; // null terminate string
+    memcpy(_payloadBuffer, payload, payloadSize);
+    _payloadBuffer[payloadSize] = 0; // null terminate string
 
-    root_value = json_parse_string(payLoadString);
+    root_value = json_parse_string(_payloadBuffer);
     if (root_value == NULL) {
         goto cleanup;
     }
@@ -133,11 +220,22 @@ static void DeviceTwinCallbackHandler(DEVICE_TWIN_UPDATE_STATE updateState,
         desiredProperties = root_object;
     }
 
-    for (int i = 0; i < _deviceTwinCount; i++) {
-        JSON_Value *jsonValue =
-            json_object_get_value(desiredProperties, _deviceTwins[i]->propertyName);
-        if (jsonValue != NULL) {
-            SetDesiredState(desiredProperties, _deviceTwins[i]);
+    JSON_Value *versionValue = json_object_get_value(desiredProperties, "$version");
+    if (json_value_get_type(versionValue) == JSONNumber) {
+        version = (int)json_value_get_number(versionValue);
+    }
+
+    size_t propertyCount = json_object_get_count(desiredProperties);
+
+    for (size_t i = 0; i < propertyCount; i++) {
+        size_t entry = twinIndexFind(json_object_get_name(desiredProperties, i));
+
+        if (entry != 0) {
+            JSON_Value *desiredValue = json_object_get_value_at(desiredProperties, i);
+
+            for (; entry != 0; entry = dx_nameIndexNext(&_twinIndex, entry)) {
+                SetDesiredState(desiredValue, version, _deviceTwins[entry - 1]);
+            }
         }
     }
 
@@ -146,29 +244,24 @@ cleanup:
     if (root_value != NULL) {
         json_value_free(root_value);
     }
-
-    if (payLoadString != NULL) {
-        free(payLoadString);
-        payLoadString = NULL;
-    }
 }
 
 /// <summary>
-///     Checks to see if the device twin propertyName(name) is found in the json object. If yes,
-///     then act upon the request
+///     Updates the binding from the desired property value if the value type matches the binding type, then
+///     calls the binding handler. version is the desired properties $version, -1 if not present.
 /// </summary>
-static void SetDesiredState(JSON_Object *jsonObject, DX_DEVICE_TWIN_BINDING *deviceTwinBinding)
+static void SetDesiredState(JSON_Value *desiredValue, int version, DX_DEVICE_TWIN_BINDING *deviceTwinBinding)
 {
-    if (json_object_has_value_of_type(jsonObject, "$version", JSONNumber)) {
-        deviceTwinBinding->propertyVersion = (int)json_object_get_number(jsonObject, "$version");
+    JSON_Value_Type valueType = json_value_get_type(desiredValue);
+
+    if (version != -1) {
+        deviceTwinBinding->propertyVersion = version;
     }
 
     switch (deviceTwinBinding->twinType) {
     case DX_DEVICE_TWIN_INT:
-        if (json_object_has_value_of_type(jsonObject, deviceTwinBinding->propertyName,
-                                          JSONNumber)) {
-            *(int *)deviceTwinBinding->propertyValue =
-                (int)json_object_get_number(jsonObject, deviceTwinBinding->propertyName);
+        if (valueType == JSONNumber) {
+            *(int *)deviceTwinBinding->propertyValue = (int)json_value_get_number(desiredValue);
 
             deviceTwinBinding->propertyUpdated = true;
 
@@ -178,10 +271,8 @@ static void SetDesiredState(JSON_Object *jsonObject, DX_DEVICE_TWIN_BINDING *dev
         }
         break;
     case DX_DEVICE_TWIN_FLOAT:
-        if (json_object_has_value_of_type(jsonObject, deviceTwinBinding->propertyName,
-                                          JSONNumber)) {
-            *(float *)deviceTwinBinding->propertyValue =
-                (float)json_object_get_number(jsonObject, deviceTwinBinding->propertyName);
+        if (valueType == JSONNumber) {
+            *(float *)deviceTwinBinding->propertyValue = (float)json_value_get_number(desiredValue);
 
             deviceTwinBinding->propertyUpdated = true;
 
@@ -191,10 +282,8 @@ static void SetDesiredState(JSON_Object *jsonObject, DX_DEVICE_TWIN_BINDING *dev
         }
         break;
     case DX_DEVICE_TWIN_DOUBLE:
-        if (json_object_has_value_of_type(jsonObject, deviceTwinBinding->propertyName,
-                                          JSONNumber)) {
-            *(double *)deviceTwinBinding->propertyValue =
-                (double)json_object_get_number(jsonObject, deviceTwinBinding->propertyName);
+        if (valueType == JSONNumber) {
+            *(double *)deviceTwinBinding->propertyValue = (double)json_value_get_number(desiredValue);
 
             deviceTwinBinding->propertyUpdated = true;
 
@@ -204,10 +293,8 @@ static void SetDesiredState(JSON_Object *jsonObject, DX_DEVICE_TWIN_BINDING *dev
         }
         break;
     case DX_DEVICE_TWIN_BOOL:
-        if (json_object_has_value_of_type(jsonObject, deviceTwinBinding->propertyName,
-                                          JSONBoolean)) {
-            *(bool *)deviceTwinBinding->propertyValue =
-                (bool)json_object_get_boolean(jsonObject, deviceTwinBinding->propertyName);
+        if (valueType == JSONBoolean) {
+            *(bool *)deviceTwinBinding->propertyValue = (bool)json_value_get_boolean(desiredValue);
 
             deviceTwinBinding->propertyUpdated = true;
 
@@ -217,10 +304,8 @@ static void SetDesiredState(JSON_Object *jsonObject, DX_DEVICE_TWIN_BINDING *dev
         }
         break;
     case DX_DEVICE_TWIN_STRING:
-        if (json_object_has_value_of_type(jsonObject, deviceTwinBinding->propertyName,
-                                          JSONString)) {
-            deviceTwinBinding->propertyValue =
-                (char *)json_object_get_string(jsonObject, deviceTwinBinding->propertyName);
+        if (valueType == JSONString) {
+            deviceTwinBinding->propertyValue = (char *)json_value_get_string(desiredValue);
 
             if (deviceTwinBinding->handler != NULL) {
                 deviceTwinBinding->handler(deviceTwinBinding);
@@ -229,10 +314,8 @@ static void SetDesiredState(JSON_Object *jsonObject, DX_DEVICE_TWIN_BINDING *dev
         }
         break;
     case DX_DEVICE_TWIN_JSON_OBJECT:
-        if (json_object_has_value_of_type(jsonObject, deviceTwinBinding->propertyName,
-                                          JSONObject)) {
-            deviceTwinBinding->propertyValue =
-                (JSON_Object *)json_object_get_object(jsonObject, deviceTwinBinding->propertyName);
+        if (valueType == JSONObject) {
+            deviceTwinBinding->propertyValue = (JSON_Object *)json_value_get_object(desiredValue);
 
             if (deviceTwinBinding->handler != NULL) {
                 deviceTwinBinding->handler(deviceTwinBinding);
@@ -259,11 +342,144 @@ bool dx_deviceTwinAckDesiredValue(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, voi
 /// </summary>
 bool dx_deviceTwinReportValue(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, void *state)
 {
-    bool result = deviceTwinReportState(deviceTwinBinding, state, false, DX_DEVICE_TWIN_RESPONSE_COMPLETED);    
-    IoTHubDeviceClient_LL_DoWork(*_iothubClientHandle);
+    bool result = deviceTwinReportState(deviceTwinBinding, state, false, DX_DEVICE_TWIN_RESPONSE_COMPLETED);
+    if (_reportFlushIntervalMs == 0) {
+        IoTHubDeviceClient_LL_DoWork(*_iothubClientHandle);
+    }
     return result;
 }
 
+void dx_deviceTwinSetReportBatching(unsigned int flushIntervalMs, size_t maxPatchBytes,
+                                    void (*reportCompleteHandler)(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, bool delivered))
+{
+    if (flushIntervalMs == 0 && _pendingReportCount > 0) {
+        deviceTwinFlushReports();
+    }
+
+    _reportFlushIntervalMs = flushIntervalMs;
+    _reportMaxPatchBytes = maxPatchBytes;
+    _reportCompleteHandler = reportCompleteHandler;
+
+    if (flushIntervalMs != 0 && !reportFlushTimer.initialized) {
+        dx_timerStart(&reportFlushTimer);
+    }
+}
+
+static void deviceTwinArmReportFlush(void)
+{
+    // batching may have been turned off with reports still pending, retry those once a second
+    unsigned int intervalMs = _reportFlushIntervalMs != 0 ? _reportFlushIntervalMs : 1000;
+    struct timespec interval = {intervalMs / 1000, (intervalMs % 1000) * 1000000};
+
+    dx_timerOneShotSet(&reportFlushTimer, &interval);
+}
+
+/// <summary>
+///     Replace the pending fragment for the property, last write wins. Takes ownership of fragment.
+/// </summary>
+static bool deviceTwinQueueReport(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, char *fragment)
+{
+    size_t entry = twinIndexFind(deviceTwinBinding->propertyName);
+
+    if (entry == 0 || _pendingReports == NULL || !reportFlushTimer.initialized) {
+        free(fragment);
+        return false;
+    }
+
+    size_t slot = entry - 1;
+
+    if (_pendingReports[slot] != NULL) {
+        _pendingReportBytes -= strlen(_pendingReports[slot]) + 1;
+        free(_pendingReports[slot]);
+    } else {
+        if (_pendingReportCount++ == 0) {
+            deviceTwinArmReportFlush();
+        }
+    }
+
+    _pendingReports[slot] = fragment;
+    _pendingReportBytes += strlen(fragment) + 1;
+
+    if (_reportMaxPatchBytes != 0 && _pendingReportBytes + 1 >= _reportMaxPatchBytes) {
+        deviceTwinFlushReports();
+    }
+
+    return true;
+}
+
+/// <summary>
+///     Merge the pending fragments into a single reported properties patch and send it
+/// </summary>
+static void deviceTwinFlushReports(void)
+{
+    DX_REPORT_BATCH *batch = NULL;
+    char *patch = NULL;
+    size_t offset = 0;
+
+    if (_pendingReportCount == 0) {
+        return;
+    }
+
+    if (!dx_isAzureConnected() || *_iothubClientHandle == NULL) {
+        // hold the pending values until the next interval
+        deviceTwinArmReportFlush();
+        return;
+    }
+
+    batch = (DX_REPORT_BATCH *)malloc(sizeof(DX_REPORT_BATCH) + _pendingReportCount * sizeof(size_t));
+    patch = (char *)malloc(_pendingReportBytes + 2);
+
+    if (batch == NULL || patch == NULL) {
+        printf("ERROR: Unable to allocate the reported properties patch, retrying next interval\n");
+        free(batch);
+        free(patch);
+        deviceTwinArmReportFlush();
+        return;
+    }
+
+    batch->count = 0;
+    patch[offset++] = '{';
+
+    for (size_t i = 0; i < _deviceTwinCount; i++) {
+        if (_pendingReports[i] != NULL) {
+            size_t len = strlen(_pendingReports[i]);
+
+            if (batch->count > 0) {
+                patch[offset++] = ',';
+            }
+
+            memcpy(patch + offset, _pendingReports[i], len);
+            offset += len;
+            batch->entries[batch->count++] = i + 1;
+
+            free(_pendingReports[i]);
+            _pendingReports[i] = NULL;
+        }
+    }
+
+    patch[offset++] = '}';
+    patch[offset] = 0;
+
+    _pendingReportCount = 0;
+    _pendingReportBytes = 0;
+
+    if (IoTHubDeviceClient_LL_SendReportedState(*_iothubClientHandle, (unsigned char *)patch, offset,
+                                                deviceTwinsReportStatusCallback, batch) != IOTHUB_CLIENT_OK) {
+        printf("ERROR: failed to set reported state for '%s'.\n", patch);
+        deviceTwinsReportStatusCallback(DX_DEVICE_TWIN_RESPONSE_ERROR, batch);
+    } else {
+        IoTHubDeviceClient_LL_DoWork(*_iothubClientHandle);
+    }
+
+    free(patch);
+}
+
+static DX_TIMER_HANDLER(ReportFlushHandler)
+{
+    deviceTwinFlushReports();
+}
+DX_TIMER_HANDLER_END
+
 /// <summary>
 ///   Supports device twin report state and device twin ack desired state request
 /// </summary>
@@ -305,17 +521,21 @@ static bool deviceTwinReportState(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, voi
 
     memset(reportedPropertiesString, 0, reportLen);
 
+    // format the "name":value fragment after the opening brace so it can be sent as is or merged into a batched patch
+    char *fragment = reportedPropertiesString + 1;
+    size_t fragmentLen = reportLen - 2;
+
     switch (deviceTwinBinding->twinType) {
     case DX_DEVICE_TWIN_INT:
         *(int *)deviceTwinBinding->propertyValue = *(int *)state;
 
         if (deviceTwinPnPAcknowledgment) {
-            len = snprintf(reportedPropertiesString, reportLen,
-                           "{\"%s\":{\"value\":%d, \"ac\":%d, \"av\":%d}}",
+            len = snprintf(fragment, fragmentLen,
+                           "\"%s\":{\"value\":%d, \"ac\":%d, \"av\":%d}",
                            deviceTwinBinding->propertyName, (*(int *)deviceTwinBinding->propertyValue),
                            (int)statusCode, deviceTwinBinding->propertyVersion);
         } else {
-            len = snprintf(reportedPropertiesString, reportLen, "{\"%s\":%d}",
+            len = snprintf(fragment, fragmentLen, "\"%s\":%d",
                            deviceTwinBinding->propertyName, (*(int *)deviceTwinBinding->propertyValue));
         }
         break;
@@ -324,13 +544,13 @@ static bool deviceTwinReportState(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, voi
 
         if (deviceTwinPnPAcknowledgment) {
             len =
-                snprintf(reportedPropertiesString, reportLen,
-                         "{\"%s\":{\"value\":%f, \"ac\":%d, \"av\":%d}}",
+                snprintf(fragment, fragmentLen,
+                         "\"%s\":{\"value\":%f, \"ac\":%d, \"av\":%d}",
                          deviceTwinBinding->propertyName, (*(float *)deviceTwinBinding->propertyValue),
                          (int)statusCode, deviceTwinBinding->propertyVersion);
         } else {
             len =
-                snprintf(reportedPropertiesString, reportLen, "{\"%s\":%f}",
+                snprintf(fragment, fragmentLen, "\"%s\":%f",
                          deviceTwinBinding->propertyName, (*(float *)deviceTwinBinding->propertyValue));
         }
         break;
@@ -339,12 +559,12 @@ static bool deviceTwinReportState(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, voi
 
         if (deviceTwinPnPAcknowledgment) {
             len =
-                snprintf(reportedPropertiesString, reportLen,
-                         "{\"%s\":{\"value\":%lf, \"ac\":%d, \"av\":%d}}",
+                snprintf(fragment, fragmentLen,
+                         "\"%s\":{\"value\":%lf, \"ac\":%d, \"av\":%d}",
                          deviceTwinBinding->propertyName, (*(double *)deviceTwinBinding->propertyValue),
                          (int)statusCode, deviceTwinBinding->propertyVersion);
         } else {
-            len = snprintf(reportedPropertiesString, reportLen, "{\"%s\":%lf}",
+            len = snprintf(fragment, fragmentLen, "\"%s\":%lf",
                            deviceTwinBinding->propertyName,
                            (*(double *)deviceTwinBinding->propertyValue));
         }
@@ -353,13 +573,13 @@ static bool deviceTwinReportState(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, voi
         *(bool *)deviceTwinBinding->propertyValue = *(bool *)state;
 
         if (deviceTwinPnPAcknowledgment) {
-            len = snprintf(reportedPropertiesString, reportLen,
-                           "{\"%s\":{\"value\":%s, \"ac\":%d, \"av\":%d}}",
+            len = snprintf(fragment, fragmentLen,
+                           "\"%s\":{\"value\":%s, \"ac\":%d, \"av\":%d}",
                            deviceTwinBinding->propertyName,
                            (*(bool *)deviceTwinBinding->propertyValue ? "true" : "false"),
                            (int)statusCode, deviceTwinBinding->propertyVersion);
         } else {
-            len = snprintf(reportedPropertiesString, reportLen, "{\"%s\":%s}",
+            len = snprintf(fragment, fragmentLen, "\"%s\":%s",
                            deviceTwinBinding->propertyName,
                            (*(bool *)deviceTwinBinding->propertyValue ? "true" : "false"));
         }
@@ -368,12 +588,12 @@ static bool deviceTwinReportState(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, voi
         deviceTwinBinding->propertyValue = NULL;
 
         if (deviceTwinPnPAcknowledgment) {
-            len = snprintf(reportedPropertiesString, reportLen,
-                           "{\"%s\":{\"value\":\"%s\", \"ac\":%d, \"av\":%d}}",
+            len = snprintf(fragment, fragmentLen,
+                           "\"%s\":{\"value\":\"%s\", \"ac\":%d, \"av\":%d}",
                            deviceTwinBinding->propertyName, (char *)state, (int)statusCode,
                            deviceTwinBinding->propertyVersion);
         } else {
-            len = snprintf(reportedPropertiesString, reportLen, "{\"%s\":\"%s\"}",
+            len = snprintf(fragment, fragmentLen, "\"%s\":\"%s\"",
                            deviceTwinBinding->propertyName, (char *)state);
         }
 
@@ -382,12 +602,12 @@ static bool deviceTwinReportState(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, voi
         deviceTwinBinding->propertyValue = NULL;
 
         if (deviceTwinPnPAcknowledgment) {
-            len = snprintf(reportedPropertiesString, reportLen,
-                           "{\"%s\":{\"value\":%s, \"ac\":%d, \"av\":%d}}",
+            len = snprintf(fragment, fragmentLen,
+                           "\"%s\":{\"value\":%s, \"ac\":%d, \"av\":%d}",
                            deviceTwinBinding->propertyName, (char *)state, (int)statusCode,
                            deviceTwinBinding->propertyVersion);
         } else {
-            len = snprintf(reportedPropertiesString, reportLen, "{\"%s\":%s}",
+            len = snprintf(fragment, fragmentLen, "\"%s\":%s",
                            deviceTwinBinding->propertyName, (char *)state);
         }
 
@@ -400,8 +620,18 @@ static bool deviceTwinReportState(DX_DEVICE_TWIN_BINDING *deviceTwinBinding, voi
         break;
     }
 
-    if (len > 0) {
-        result = deviceTwinUpdateReportedState(reportedPropertiesString);
+    if (len > 0 && (size_t)len < fragmentLen) {
+        if (_reportFlushIntervalMs != 0) {
+            memmove(reportedPropertiesString, fragment, (size_t)len + 1);
+            // the queue takes ownership of the fragment
+            result = deviceTwinQueueReport(deviceTwinBinding, reportedPropertiesString);
+            reportedPropertiesString = NULL;
+        } else {
+            reportedPropertiesString[0] = '{';
+            reportedPropertiesString[len + 1] = '}';
+            reportedPropertiesString[len + 2] = 0;
+            result = deviceTwinUpdateReportedState(reportedPropertiesString);
+        }
     }
 
     if (reportedPropertiesString != NULL) {
@@ -429,10 +659,25 @@ static bool deviceTwinUpdateReportedState(char *reportedPropertiesString)
 
 /// <summary>
 ///     Callback invoked when the Device Twin reported properties are accepted by IoT Hub.
+/// context is the DX_REPORT_BATCH for batched reports, NULL otherwise.
 /// </summary>
 void deviceTwinsReportStatusCallback(int result, void *context)
 {
+    DX_REPORT_BATCH *batch = (DX_REPORT_BATCH *)context;
+
 #if DX_LOGGING_ENABLED
     printf("INFO: Device Twin reported properties update result: HTTP status code %d\n", result);
 #endif
+
+    if (batch != NULL) {
+        if (_reportCompleteHandler != NULL) {
+            for (size_t i = 0; i < batch->count; i++) {
+                // the bindings may have been unsubscribed while the patch was in flight
+                if (batch->entries[i] <= _deviceTwinCount && _pendingReports != NULL) {
+                    _reportCompleteHandler(_deviceTwins[batch->entries[i] - 1], result >= 200 && result < 300);
+                }
+            }
+        }
+        free(batch);
+    }
 }
\ No newline at end of file
@@ -4,9 +4,10 @@
 #include "dx_direct_methods.h"
 
 #include "dx_azure_iot.h"
+#include "dx_name_index.h"
+#include <stdint.h>
 #include <stdlib.h>
-
-
+#include <string.h>
 
 static int DirectMethodCallbackHandler(const char *method_name, const unsigned char *payload, size_t payloadSize,
                                        unsigned char **responsePayload, size_t *responsePayloadSize, void *userContextCallback);
@@ -14,33 +15,123 @@ static int DirectMethodCallbackHandler(const char *method_name, const unsigned c
 static DX_DIRECT_METHOD_BINDING **_directMethods;
 static size_t _directMethodCount;
 
+// Method name dispatch table built at subscribe time, if a method name is bound more than once the first binding wins.
+// The table is at most half full, a few slots per binding.
+static DX_NAME_INDEX _methodIndex;
+
+// The method being handled, the payload is only copied and parsed if the handler asks for it
+static const unsigned char *_requestPayload = NULL;
+static size_t _requestPayloadSize = 0;
+static JSON_Value *_requestJson = NULL;
+static bool _requestJsonParsed = false;
+
+// Reused across methods, payloads are copied to null terminate them for parson
+static char *_payloadBuffer = NULL;
+static size_t _payloadBufferSize = 0;
+static char _responseBuffer[DX_DIRECT_METHOD_RESPONSE_BUFFER_SIZE];
+
+static const char *methodBindingName(size_t item, void *context)
+{
+    return _directMethods[item]->methodName;
+}
+
+static DX_DIRECT_METHOD_BINDING *methodIndexFind(const char *name)
+{
+    size_t entry = dx_nameIndexFind(&_methodIndex, name, methodBindingName, NULL);
+
+    // the table could not be allocated, scan the bindings instead
+    if (_methodIndex.size == 0) {
+        for (size_t i = 0; i < _directMethodCount && entry == 0; i++) {
+            if (strcmp(_directMethods[i]->methodName, name) == 0) {
+                entry = i + 1;
+            }
+        }
+    }
+
+    return entry != 0 ? _directMethods[entry - 1] : NULL;
+}
+
+/// <summary>
+///     Grow only buffer, returns false if the buffer could not be grown
+/// </summary>
+static bool reserveBuffer(char **buffer, size_t *bufferSize, size_t size)
+{
+    if (size > *bufferSize) {
+        char *newBuffer = (char *)realloc(*buffer, size);
+        if (newBuffer == NULL) {
+            return false;
+        }
+        *buffer = newBuffer;
+        *bufferSize = size;
+    }
+    return true;
+}
+
 void dx_directMethodSubscribe(DX_DIRECT_METHOD_BINDING *directMethods[], size_t directMethodCount)
 {
     dx_azureRegisterDirectMethodCallback(DirectMethodCallbackHandler);
 
     _directMethods = directMethods;
     _directMethodCount = directMethodCount;
+
+    if (!dx_nameIndexBuild(&_methodIndex, _directMethodCount, methodBindingName, NULL, false)) {
+        printf("ERROR: Unable to build the direct method dispatch table, falling back to a linear search\n");
+    }
 }
 
 void dx_directMethodUnsubscribe(void)
 {
     dx_azureRegisterDirectMethodCallback(NULL);
 
+    dx_nameIndexFree(&_methodIndex);
+
     _directMethods = NULL;
     _directMethodCount = 0;
+
+    free(_payloadBuffer);
+    _payloadBuffer = NULL;
+    _payloadBufferSize = 0;
+}
+
+JSON_Value *dx_directMethodPayloadJson(void)
+{
+    if (!_requestJsonParsed && _requestPayload != NULL) {
+        _requestJsonParsed = true;
+
+        if (reserveBuffer(&_payloadBuffer, &_payloadBufferSize, _requestPayloadSize + 1)) {
+            memcpy(_payloadBuffer, _requestPayload, _requestPayloadSize);
+            _payloadBuffer[_requestPayloadSize] = 0; // null terminate string
+
+            _requestJson = json_parse_string(_payloadBuffer);
+        }
+    }
+
+    return _requestJson;
+}
+
+const unsigned char *dx_directMethodPayload(size_t *payloadSize)
+{
+    if (payloadSize != NULL) {
+        *payloadSize = _requestPayloadSize;
+    }
+    return _requestPayload;
+}
+
+char *dx_directMethodResponseBuffer(void)
+{
+    return _responseBuffer;
 }
 
 /*
 This implementation of Direct Methods expects a JSON Payload Object
 */
-static int DirectMethodCallbackHandler(const char *method_name, const unsigned char *payload,
-                                          size_t payloadSize, unsigned char **responsePayload,
-                                          size_t *responsePayloadSize, void *userContextCallback)
+static int DirectMethodCallbackHandler(const char *method_name, const unsigned char *payload, size_t payloadSize,
+                                       unsigned char **responsePayload, size_t *responsePayloadSize, void *userContextCallback)
 {
+    static const char responseFailedMsg[] = "\"Method Error\"";
     const char *methodSucceededMsg = "Method Succeeded";
     const char *methodNotFoundMsg = "Method not found";
     const char *methodErrorMsg = "Method Error";
-    const char *mallocFailedMsg = "Memory Allocation failed";
     const char *invalidJsonMsg = "Invalid JSON";
 
     DX_DIRECT_METHOD_RESPONSE_CODE responseCode = DX_METHOD_NOT_FOUND;
@@ -52,42 +143,24 @@ static int DirectMethodCallbackHandler(const char *method_name, const unsigned c
     int result = DX_METHOD_NOT_FOUND;
     size_t responseMessageLength;
 
-    JSON_Value *root_value = NULL;
-
-    // Prepare the payload for the response. This is a heap allocated null terminated string.
-    // The Azure IoT Hub SDK is responsible of freeing it.
-    *responsePayload = NULL;  // Response payload content.
-    *responsePayloadSize = 0; // Response payload content size.
-
-    char *payLoadString = (char *)malloc(payloadSize + 1);
-    if (payLoadString == NULL) {
-        responseMessage = mallocFailedMsg;
-        result = DX_METHOD_FAILED;
-        goto cleanup;
-    }
+    _requestPayload = payload;
+    _requestPayloadSize = payloadSize;
+    _requestJson = NULL;
+    _requestJsonParsed = false;
+    _responseBuffer[0] = 0;
 
-    memset(payLoadString, 0x00, payloadSize + 1);
+    directMethodBinding = methodIndexFind(method_name);
 
-    memcpy(payLoadString, payload, payloadSize);
-    payLoadString[payloadSize] = 0; // null terminate string
+    if (directMethodBinding != NULL &&
+        directMethodBinding->handler != NULL) { // was a DX_DIRECT_METHOD_BINDING found
 
-    root_value = json_parse_string(payLoadString);
-    if (root_value == NULL) {
-        responseMessage = invalidJsonMsg;
-        result = DX_METHOD_FAILED;
-        goto cleanup;
-    }
+        JSON_Value *root_value = NULL;
 
-    // loop through array of DirectMethodBindings looking for a matching method name
-    for (int i = 0; i < _directMethodCount; i++) {
-        if (strcmp(method_name, _directMethods[i]->methodName) == 0) {
-            directMethodBinding = _directMethods[i];
-            break;
+        if (!directMethodBinding->lazyPayload && (root_value = dx_directMethodPayloadJson()) == NULL) {
+            responseMessage = invalidJsonMsg;
+            result = DX_METHOD_FAILED;
+            goto cleanup;
         }
-    }
-
-    if (directMethodBinding != NULL &&
-        directMethodBinding->handler != NULL) { // was a DX_DIRECT_METHOD_BINDING found
 
         responseCode = directMethodBinding->handler(root_value, directMethodBinding, &responseMsg);
 
@@ -109,37 +182,37 @@ static int DirectMethodCallbackHandler(const char *method_name, const unsigned c
 
 cleanup:
 
-    // Prepare the payload for the response.
+    // response message needs to be wrapped in quotes as it is part of the JSON payload object.
     // The Azure IoT Hub SDK is responsible of freeing it.
     responseMessageLength = strlen(responseMessage);
-    *responsePayloadSize =
-        responseMessageLength + 2; // add two as going to wrap the message with quotes for JSON
-
-    *responsePayload = (unsigned char *)malloc(*responsePayloadSize);
-    if (*responsePayload != NULL) {
-        memset(*responsePayload, 0x00, *responsePayloadSize);
 
-        // response message needs to be wrapped in quotes as it is part of the JSON payload object
-        memcpy(*responsePayload, "\"", 1);
+    if ((*responsePayload = (unsigned char *)malloc(responseMessageLength + 2)) != NULL) {
+        (*responsePayload)[0] = '"';
         memcpy(*responsePayload + 1, responseMessage, responseMessageLength);
-        memcpy(*responsePayload + responseMessageLength + 1, "\"", 1);
+        (*responsePayload)[responseMessageLength + 1] = '"';
+        *responsePayloadSize = responseMessageLength + 2;
+    } else if ((*responsePayload = (unsigned char *)malloc(sizeof(responseFailedMsg) - 1)) != NULL) {
+        // the SDK does not answer a method without a response body, fall back to a short error
+        memcpy(*responsePayload, responseFailedMsg, sizeof(responseFailedMsg) - 1);
+        *responsePayloadSize = sizeof(responseFailedMsg) - 1;
+        result = DX_METHOD_FAILED;
     } else {
         *responsePayloadSize = 0;
     }
 
-    if (root_value != NULL) {
-        json_value_free(root_value);
+    if (_requestJson != NULL) {
+        json_value_free(_requestJson);
+        _requestJson = NULL;
     }
 
-    if (payLoadString != NULL) {
-        free(payLoadString);
-        payLoadString = NULL;
-    }
+    _requestPayload = NULL;
+    _requestPayloadSize = 0;
 
-    if (responseMsg != NULL) { // there was memory allocated for a response message so free it now
+    // there was memory allocated for a response message so free it now, unless the handler used the response buffer
+    if (responseMsg != NULL && responseMsg != _responseBuffer) {
         free(responseMsg);
         responseMsg = NULL;
     }
 
     return result;
-}
\ No newline at end of file
+}
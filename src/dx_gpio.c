@@ -6,10 +6,15 @@
 #include <gpiod.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
+#include <uv.h>
 
 #define MAX_CHIP_NUMBER 6
 
+// edge events read from the line fd per wake up, more than this stay queued and the poll fires again
+#define GPIO_EDGE_EVENT_BATCH 16
+
 // https://libgpiod-dlang.dpldocs.info/gpiod.html
 
 typedef struct
@@ -20,6 +25,112 @@ typedef struct
 
 GPIO_CHIP_T gpio_chips[MAX_CHIP_NUMBER];
 
+typedef struct
+{
+    uv_poll_t poll;
+    DX_GPIO_BINDING *gpio_binding;
+    struct timespec last_edge;
+    bool edge_reported;
+} GPIO_EDGE_WATCH_T;
+
+static void edge_watch_closed(uv_handle_t *handle)
+{
+    free(handle->data);
+}
+
+static bool edge_debounced(GPIO_EDGE_WATCH_T *watch, const struct timespec *timestamp)
+{
+    if (watch->gpio_binding->debounce_ms == 0 || !watch->edge_reported)
+    {
+        return false;
+    }
+
+    int64_t elapsed_ms = (int64_t)(timestamp->tv_sec - watch->last_edge.tv_sec) * 1000 + (timestamp->tv_nsec - watch->last_edge.tv_nsec) / 1000000;
+
+    return elapsed_ms >= 0 && elapsed_ms < (int64_t)watch->gpio_binding->debounce_ms;
+}
+
+static void edge_event_handler(uv_poll_t *handle, int status, int events)
+{
+    GPIO_EDGE_WATCH_T *watch = (GPIO_EDGE_WATCH_T *)handle->data;
+    DX_GPIO_BINDING *gpio_binding = watch->gpio_binding;
+    struct gpiod_line_event line_events[GPIO_EDGE_EVENT_BATCH];
+    int count;
+
+    if (status < 0 || !gpio_binding->__line_handle)
+    {
+        return;
+    }
+
+    // one read returns every queued event up to the batch size
+    if ((count = gpiod_line_event_read_multiple(gpio_binding->__line_handle, line_events, GPIO_EDGE_EVENT_BATCH)) <= 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < count && gpio_binding->__line_handle; i++)
+    {
+        if (edge_debounced(watch, &line_events[i].ts))
+        {
+            continue;
+        }
+
+        watch->last_edge = line_events[i].ts;
+        watch->edge_reported = true;
+
+        gpio_binding->edge_handler(gpio_binding, line_events[i].event_type == GPIOD_LINE_EVENT_RISING_EDGE ? DX_GPIO_HIGH : DX_GPIO_LOW,
+                                   &line_events[i].ts);
+    }
+}
+
+static int request_edge_events(DX_GPIO_BINDING *gpio_binding)
+{
+    switch (gpio_binding->detect)
+    {
+    case DX_GPIO_DETECT_LOW:
+        return gpiod_line_request_falling_edge_events(gpio_binding->__line_handle, gpio_binding->name);
+    case DX_GPIO_DETECT_HIGH:
+        return gpiod_line_request_rising_edge_events(gpio_binding->__line_handle, gpio_binding->name);
+    default:
+        return gpiod_line_request_both_edges_events(gpio_binding->__line_handle, gpio_binding->name);
+    }
+}
+
+static bool start_edge_watch(DX_GPIO_BINDING *gpio_binding)
+{
+    GPIO_EDGE_WATCH_T *watch = calloc(1, sizeof(GPIO_EDGE_WATCH_T));
+    if (!watch)
+    {
+        return false;
+    }
+
+    watch->gpio_binding = gpio_binding;
+    watch->poll.data = watch;
+
+    if (uv_poll_init(uv_default_loop(), &watch->poll, gpiod_line_event_get_fd(gpio_binding->__line_handle)) != 0)
+    {
+        free(watch);
+        return false;
+    }
+
+    uv_poll_start(&watch->poll, UV_READABLE, edge_event_handler);
+    gpio_binding->__edge_watch = watch;
+
+    return true;
+}
+
+static void stop_edge_watch(DX_GPIO_BINDING *gpio_binding)
+{
+    GPIO_EDGE_WATCH_T *watch = (GPIO_EDGE_WATCH_T *)gpio_binding->__edge_watch;
+
+    if (watch)
+    {
+        uv_poll_stop(&watch->poll);
+        uv_close((uv_handle_t *)&watch->poll, edge_watch_closed);
+        gpio_binding->__edge_watch = NULL;
+    }
+}
+
 static void close_chip(int chip_number)
 {
     if (gpio_chips[chip_number].count == 0)
@@ -62,7 +173,22 @@ bool dx_gpioOpen(DX_GPIO_BINDING *gpio_binding)
         return false;
     }
 
-    if (DX_GPIO_INPUT == gpio_binding->direction)
+    if (DX_GPIO_INPUT == gpio_binding->direction && gpio_binding->edge_handler)
+    {
+        if (request_edge_events(gpio_binding) == -1)
+        {
+            close_chip(gpio_binding->chip_number);
+            return false;
+        }
+
+        if (!start_edge_watch(gpio_binding))
+        {
+            gpiod_line_release(gpio_binding->__line_handle);
+            close_chip(gpio_binding->chip_number);
+            return false;
+        }
+    }
+    else if (DX_GPIO_INPUT == gpio_binding->direction)
     {
         if (gpiod_line_request_input(gpio_binding->__line_handle, gpio_binding->name) == -1)
         {
@@ -88,6 +214,9 @@ bool dx_gpioClose(DX_GPIO_BINDING *gpio_binding)
 {
     if (gpio_binding->__line_handle)
     {
+        // stop watching before the line fd is closed by the release
+        stop_edge_watch(gpio_binding);
+
         gpiod_line_release(gpio_binding->__line_handle);
 
         gpio_binding->__line_handle = NULL;
@@ -147,3 +276,136 @@ void dx_gpioSetClose(DX_GPIO_BINDING **gpio_bindings, size_t gpio_bindings_count
         dx_gpioClose(gpio_bindings[i]);
     }
 }
+
+bool dx_gpioGroupOpen(DX_GPIO_GROUP *gpio_group)
+{
+    unsigned int offsets[DX_GPIO_GROUP_MAX_LINES];
+    int values[DX_GPIO_GROUP_MAX_LINES];
+    struct gpiod_line_bulk *bulk = NULL;
+
+    if (gpio_group->__bulk_handle)
+    {
+        return true;
+    }
+
+    // clang-format off
+    if (DX_GPIO_DIRECTION_UNKNOWN == gpio_group->direction ||
+        gpio_group->chip_number < 0 ||
+        gpio_group->chip_number >= MAX_CHIP_NUMBER ||
+        gpio_group->line_numbers == NULL ||
+        gpio_group->line_count == 0 ||
+        gpio_group->line_count > DX_GPIO_GROUP_MAX_LINES)
+    {
+        return false;
+    }
+    // clang-format on
+
+    if (!gpio_chips[gpio_group->chip_number].chip)
+    {
+        gpio_chips[gpio_group->chip_number].chip = gpiod_chip_open_by_number(gpio_group->chip_number);
+        if (!gpio_chips[gpio_group->chip_number].chip)
+        {
+            return false;
+        }
+    }
+
+    if (!(bulk = malloc(sizeof(struct gpiod_line_bulk))))
+    {
+        close_chip(gpio_group->chip_number);
+        return false;
+    }
+
+    for (size_t i = 0; i < gpio_group->line_count; i++)
+    {
+        offsets[i] = gpio_group->line_numbers[i];
+        values[i] = (gpio_group->initial_state >> i) & 1;
+    }
+
+    if (gpiod_chip_get_lines(gpio_chips[gpio_group->chip_number].chip, offsets, gpio_group->line_count, bulk) == -1)
+    {
+        free(bulk);
+        close_chip(gpio_group->chip_number);
+        return false;
+    }
+
+    if (DX_GPIO_INPUT == gpio_group->direction)
+    {
+        if (gpiod_line_request_bulk_input(bulk, gpio_group->name) == -1)
+        {
+            free(bulk);
+            close_chip(gpio_group->chip_number);
+            return false;
+        }
+    }
+    else
+    {
+        if (gpiod_line_request_bulk_output(bulk, gpio_group->name, values) == -1)
+        {
+            free(bulk);
+            close_chip(gpio_group->chip_number);
+            return false;
+        }
+    }
+
+    gpio_group->__bulk_handle = bulk;
+    gpio_chips[gpio_group->chip_number].count++;
+
+    return true;
+}
+
+bool dx_gpioGroupClose(DX_GPIO_GROUP *gpio_group)
+{
+    if (gpio_group->__bulk_handle)
+    {
+        gpiod_line_release_bulk(gpio_group->__bulk_handle);
+        free(gpio_group->__bulk_handle);
+
+        gpio_group->__bulk_handle = NULL;
+
+        gpio_chips[gpio_group->chip_number].count--;
+        close_chip(gpio_group->chip_number);
+    }
+
+    return true;
+}
+
+bool dx_gpioGroupWrite(DX_GPIO_GROUP *gpio_group, uint32_t state)
+{
+    int values[DX_GPIO_GROUP_MAX_LINES];
+
+    if (!gpio_group->__bulk_handle || DX_GPIO_OUTPUT != gpio_group->direction)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < gpio_group->line_count; i++)
+    {
+        values[i] = (state >> i) & 1;
+    }
+
+    // all lines are set by one ioctl
+    return 0 == gpiod_line_set_value_bulk(gpio_group->__bulk_handle, values);
+}
+
+bool dx_gpioGroupRead(DX_GPIO_GROUP *gpio_group, uint32_t *state)
+{
+    int values[DX_GPIO_GROUP_MAX_LINES];
+
+    if (!gpio_group->__bulk_handle || !state)
+    {
+        return false;
+    }
+
+    if (gpiod_line_get_value_bulk(gpio_group->__bulk_handle, values) == -1)
+    {
+        return false;
+    }
+
+    *state = 0;
+    for (size_t i = 0; i < gpio_group->line_count; i++)
+    {
+        *state |= (uint32_t)(values[i] & 1) << i;
+    }
+
+    return true;
+}
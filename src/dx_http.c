@@ -0,0 +1,307 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#include "dx_http.h"
+
+#include <curl/curl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uv.h>
+
+// One curl multi handle for the process, driven by the libuv default loop.
+// https://curl.se/libcurl/c/multi-uv.html
+
+typedef struct
+{
+    uv_poll_t poll;
+    curl_socket_t sockfd;
+} HTTP_SOCKET_CONTEXT;
+
+typedef struct _httpTransfer
+{
+    struct _httpTransfer *next;
+    CURL *easy;
+    char *body;
+    size_t bodySize;
+    DX_HTTP_DATA_HANDLER dataHandler;
+    DX_HTTP_RESPONSE_HANDLER responseHandler;
+    void *context;
+} HTTP_TRANSFER;
+
+static CURLM *multi_handle = NULL;
+static CURLSH *share_handle = NULL;
+static uv_timer_t timeout_timer;
+static bool timeout_timer_initialized = false;
+static HTTP_TRANSFER *transfers = NULL; // in-flight transfers, cancelled by dx_httpCleanup
+
+static void check_multi_info(void);
+
+static void socket_context_closed(uv_handle_t *handle)
+{
+    free(handle->data);
+}
+
+static void curl_perform(uv_poll_t *req, int status, int events)
+{
+    HTTP_SOCKET_CONTEXT *socket_context = (HTTP_SOCKET_CONTEXT *)req->data;
+    int running_handles;
+    int flags = 0;
+
+    if (status < 0) {
+        flags = CURL_CSELECT_ERR;
+    }
+    if (events & UV_READABLE) {
+        flags |= CURL_CSELECT_IN;
+    }
+    if (events & UV_WRITABLE) {
+        flags |= CURL_CSELECT_OUT;
+    }
+
+    curl_multi_socket_action(multi_handle, socket_context->sockfd, flags, &running_handles);
+    check_multi_info();
+}
+
+static void on_timeout(uv_timer_t *req)
+{
+    int running_handles;
+    curl_multi_socket_action(multi_handle, CURL_SOCKET_TIMEOUT, 0, &running_handles);
+    check_multi_info();
+}
+
+static int start_timeout(CURLM *multi, long timeout_ms, void *userp)
+{
+    if (timeout_ms < 0) {
+        uv_timer_stop(&timeout_timer);
+    } else {
+        // a zero timeout means call socket_action as soon as possible, do it on the next loop iteration rather than recursing
+        uv_timer_start(&timeout_timer, on_timeout, timeout_ms == 0 ? 1 : (uint64_t)timeout_ms, 0);
+    }
+    return 0;
+}
+
+static int handle_socket(CURL *easy, curl_socket_t s, int action, void *userp, void *socketp)
+{
+    HTTP_SOCKET_CONTEXT *socket_context = (HTTP_SOCKET_CONTEXT *)socketp;
+    int events = 0;
+
+    switch (action) {
+    case CURL_POLL_IN:
+    case CURL_POLL_OUT:
+    case CURL_POLL_INOUT:
+        if (socket_context == NULL) {
+            if ((socket_context = (HTTP_SOCKET_CONTEXT *)malloc(sizeof(HTTP_SOCKET_CONTEXT))) == NULL) {
+                return -1;
+            }
+            socket_context->sockfd = s;
+            uv_poll_init_socket(uv_default_loop(), &socket_context->poll, s);
+            socket_context->poll.data = socket_context;
+            curl_multi_assign(multi_handle, s, socket_context);
+        }
+
+        if (action != CURL_POLL_IN) {
+            events |= UV_WRITABLE;
+        }
+        if (action != CURL_POLL_OUT) {
+            events |= UV_READABLE;
+        }
+
+        uv_poll_start(&socket_context->poll, events, curl_perform);
+        break;
+    case CURL_POLL_REMOVE:
+        if (socket_context != NULL) {
+            uv_poll_stop(&socket_context->poll);
+            uv_close((uv_handle_t *)&socket_context->poll, socket_context_closed);
+            curl_multi_assign(multi_handle, s, NULL);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp)
+{
+    size_t realsize = size * nmemb;
+    HTTP_TRANSFER *transfer = (HTTP_TRANSFER *)userp;
+
+    if (transfer->dataHandler != NULL) {
+        return transfer->dataHandler((const char *)contents, realsize, transfer->context) ? realsize : 0;
+    }
+
+    char *ptr = realloc(transfer->body, transfer->bodySize + realsize + 1);
+    if (!ptr) {
+        /* out of memory! */
+        printf("not enough memory (realloc returned NULL)\n");
+        return 0;
+    }
+
+    transfer->body = ptr;
+    memcpy(&(transfer->body[transfer->bodySize]), contents, realsize);
+    transfer->bodySize += realsize;
+    transfer->body[transfer->bodySize] = 0;
+
+    return realsize;
+}
+
+static void complete_transfer(HTTP_TRANSFER *transfer, CURLcode result)
+{
+    long http_status = 0;
+
+    for (HTTP_TRANSFER **link = &transfers; *link != NULL; link = &(*link)->next) {
+        if (*link == transfer) {
+            *link = transfer->next;
+            break;
+        }
+    }
+
+    curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &http_status);
+    curl_multi_remove_handle(multi_handle, transfer->easy);
+    curl_easy_cleanup(transfer->easy);
+
+    if (transfer->responseHandler != NULL) {
+        transfer->responseHandler(result == CURLE_OK, http_status, transfer->dataHandler != NULL ? NULL : (transfer->body ? transfer->body : ""),
+                                  transfer->bodySize, transfer->context);
+    }
+
+    free(transfer->body);
+    free(transfer);
+}
+
+static void check_multi_info(void)
+{
+    CURLMsg *message;
+    int pending;
+
+    while ((message = curl_multi_info_read(multi_handle, &pending))) {
+        if (message->msg == CURLMSG_DONE) {
+            HTTP_TRANSFER *transfer = NULL;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, (char **)&transfer);
+            complete_transfer(transfer, message->data.result);
+        }
+    }
+}
+
+static bool http_init(void)
+{
+    if (multi_handle != NULL) {
+        return true;
+    }
+
+    if (curl_global_init(CURL_GLOBAL_ALL) != CURLE_OK) {
+        return false;
+    }
+
+    if ((multi_handle = curl_multi_init()) == NULL) {
+        return false;
+    }
+
+    // the multi handle pools connections per host, DNS results and TLS sessions are shared by every request
+    if ((share_handle = curl_share_init()) != NULL) {
+        curl_share_setopt(share_handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    if (!timeout_timer_initialized) {
+        uv_timer_init(uv_default_loop(), &timeout_timer);
+        timeout_timer_initialized = true;
+    }
+
+    curl_multi_setopt(multi_handle, CURLMOPT_SOCKETFUNCTION, handle_socket);
+    curl_multi_setopt(multi_handle, CURLMOPT_TIMERFUNCTION, start_timeout);
+    curl_multi_setopt(multi_handle, CURLMOPT_MAXCONNECTS, (long)DX_HTTP_MAX_CONNECTIONS);
+    curl_multi_setopt(multi_handle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+    return true;
+}
+
+bool dx_httpRequestAsync(const DX_HTTP_REQUEST *request)
+{
+    HTTP_TRANSFER *transfer = NULL;
+
+    if (request == NULL || request->url == NULL || !http_init()) {
+        return false;
+    }
+
+    if ((transfer = (HTTP_TRANSFER *)calloc(1, sizeof(HTTP_TRANSFER))) == NULL) {
+        return false;
+    }
+
+    if ((transfer->easy = curl_easy_init()) == NULL) {
+        free(transfer);
+        return false;
+    }
+
+    transfer->dataHandler = request->dataHandler;
+    transfer->responseHandler = request->responseHandler;
+    transfer->context = request->context;
+
+    curl_easy_setopt(transfer->easy, CURLOPT_URL, request->url);
+    curl_easy_setopt(transfer->easy, CURLOPT_PRIVATE, transfer);
+    curl_easy_setopt(transfer->easy, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(transfer->easy, CURLOPT_WRITEDATA, (void *)transfer);
+
+    if (share_handle != NULL) {
+        curl_easy_setopt(transfer->easy, CURLOPT_SHARE, share_handle);
+    }
+
+    if (request->headers != NULL) {
+        curl_easy_setopt(transfer->easy, CURLOPT_HTTPHEADER, request->headers);
+    }
+
+    if (request->postData != NULL) {
+        curl_easy_setopt(transfer->easy, CURLOPT_COPYPOSTFIELDS, request->postData);
+    } else {
+        curl_easy_setopt(transfer->easy, CURLOPT_HTTPGET, 1L);
+    }
+
+    curl_easy_setopt(transfer->easy, CURLOPT_TIMEOUT, request->timeoutSeconds);
+
+    /* some servers do not like requests that are made without a user-agent
+       field, so we provide one */
+    curl_easy_setopt(transfer->easy, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+
+    // based on the libcurl sample - https://curl.se/libcurl/c/https.html
+    curl_easy_setopt(transfer->easy, CURLOPT_SSL_VERIFYPEER, 0L);
+
+    // https://curl.se/libcurl/c/CURLOPT_NOSIGNAL.html
+    curl_easy_setopt(transfer->easy, CURLOPT_NOSIGNAL, 1L);
+
+    // keep pooled connections alive between requests
+    curl_easy_setopt(transfer->easy, CURLOPT_TCP_KEEPALIVE, 1L);
+
+    if (curl_multi_add_handle(multi_handle, transfer->easy) != CURLM_OK) {
+        curl_easy_cleanup(transfer->easy);
+        free(transfer);
+        return false;
+    }
+
+    transfer->next = transfers;
+    transfers = transfer;
+
+    return true;
+}
+
+void dx_httpCleanup(void)
+{
+    if (multi_handle == NULL) {
+        return;
+    }
+
+    while (transfers != NULL) {
+        complete_transfer(transfers, CURLE_ABORTED_BY_CALLBACK);
+    }
+
+    uv_timer_stop(&timeout_timer);
+
+    // closes pooled connections, removing their sockets through handle_socket
+    curl_multi_cleanup(multi_handle);
+    multi_handle = NULL;
+
+    if (share_handle != NULL) {
+        curl_share_cleanup(share_handle);
+        share_handle = NULL;
+    }
+}
@@ -4,61 +4,416 @@
 #include "dx_json_serializer.h"
 
 #include "dx_utilities.h"
-#include "parson.h"
-#include "stdarg.h"
-#include "stdio.h"
-#include "string.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-bool dx_jsonSerialize(char *buffer, size_t buffer_size, int key_value_pair_count, ...)
+// largest precision where value * 10^precision still fits in 64 bits for useful ranges
+#define JSON_MAX_PRECISION 17
+
+static const uint64_t power_of_ten[JSON_MAX_PRECISION + 1] = {1ull,
+                                                              10ull,
+                                                              100ull,
+                                                              1000ull,
+                                                              10000ull,
+                                                              100000ull,
+                                                              1000000ull,
+                                                              10000000ull,
+                                                              100000000ull,
+                                                              1000000000ull,
+                                                              10000000000ull,
+                                                              100000000000ull,
+                                                              1000000000000ull,
+                                                              10000000000000ull,
+                                                              100000000000000ull,
+                                                              1000000000000000ull,
+                                                              10000000000000000ull,
+                                                              100000000000000000ull};
+
+void dx_jsonWriterInit(DX_JSON_WRITER *writer, char *buffer, size_t buffer_size)
 {
-    JSON_Value *root_value = json_value_init_object();
-    JSON_Object *root_object = json_value_get_object(root_value);
+    writer->buffer = buffer;
+    writer->size = buffer_size;
+    writer->length = 0;
+    writer->overflow = buffer == NULL || buffer_size == 0;
 
-    char *json_string = NULL;
-    char *key = NULL;
-    bool result = false;
+    if (!writer->overflow) {
+        buffer[0] = 0;
+    }
+}
 
-    va_list valist;
-    va_start(valist, key_value_pair_count);
+void dx_jsonWriteRaw(DX_JSON_WRITER *writer, const char *text, size_t length)
+{
+    if (writer->overflow) {
+        return;
+    }
 
-    while (key_value_pair_count--) {
-        DX_JSON_TYPE type = va_arg(valist, int);
-        key = va_arg(valist, char *);
+    // leave room for the null terminator
+    if (length >= writer->size - writer->length) {
+        writer->overflow = true;
+        return;
+    }
 
-        switch (type) {
-        case DX_JSON_INT:
-            json_object_set_number(root_object, key, va_arg(valist, int));
-            break;
+    memcpy(writer->buffer + writer->length, text, length);
+    writer->length += length;
+    writer->buffer[writer->length] = 0;
+}
 
-            // floats are cast to doubles for valists
-        case DX_JSON_FLOAT:
-        case DX_JSON_DOUBLE:
-            json_object_set_number(root_object, key, va_arg(valist, double));
-            break;
+static size_t json_escape_length(const char *text)
+{
+    const unsigned char *c = (const unsigned char *)text;
+    size_t length = 0;
 
-        case DX_JSON_STRING:
-            json_object_set_string(root_object, key, va_arg(valist, char *));
-            break;
+    while (*c) {
+        if (*c == '"' || *c == '\\' || *c == '\b' || *c == '\f' || *c == '\n' || *c == '\r' || *c == '\t') {
+            length += 2;
+        } else if (*c < 0x20) {
+            length += 6; // \u00XX
+        } else {
+            length += 1;
+        }
+        c++;
+    }
 
-        case DX_JSON_BOOL:
-            json_object_set_boolean(root_object, key, va_arg(valist, int));
-            break;
+    return length;
+}
+
+void dx_jsonWriteString(DX_JSON_WRITER *writer, const char *value)
+{
+    static const char hex[] = "0123456789abcdef";
+    const unsigned char *run;
+    const unsigned char *c;
+
+    if (value == NULL) {
+        dx_jsonWriteRaw(writer, "null", 4);
+        return;
+    }
+
+    dx_jsonWriteRaw(writer, "\"", 1);
+
+    // copy runs that need no escaping in one go
+    run = c = (const unsigned char *)value;
+    while (*c) {
+        char escape[6] = {'\\', 0, '0', '0', 0, 0};
+        size_t escape_length = 2;
 
+        if (*c >= 0x20 && *c != '"' && *c != '\\') {
+            c++;
+            continue;
+        }
+
+        dx_jsonWriteRaw(writer, (const char *)run, (size_t)(c - run));
+
+        switch (*c) {
+        case '"':
+        case '\\':
+            escape[1] = (char)*c;
+            break;
+        case '\b':
+            escape[1] = 'b';
+            break;
+        case '\f':
+            escape[1] = 'f';
+            break;
+        case '\n':
+            escape[1] = 'n';
+            break;
+        case '\r':
+            escape[1] = 'r';
+            break;
+        case '\t':
+            escape[1] = 't';
+            break;
         default:
+            escape[1] = 'u';
+            escape[4] = hex[*c >> 4];
+            escape[5] = hex[*c & 0x0f];
+            escape_length = 6;
             break;
         }
+
+        dx_jsonWriteRaw(writer, escape, escape_length);
+        run = ++c;
     }
-    va_end(valist);
 
-    json_string = json_serialize_to_string(root_value);
+    dx_jsonWriteRaw(writer, (const char *)run, (size_t)(c - run));
+    dx_jsonWriteRaw(writer, "\"", 1);
+}
+
+static size_t format_unsigned(char *end, uint64_t value)
+{
+    char *p = end;
+
+    do {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    return (size_t)(end - p);
+}
+
+void dx_jsonWriteInt(DX_JSON_WRITER *writer, long long value)
+{
+    char digits[24];
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    size_t length = format_unsigned(digits + sizeof(digits), magnitude);
+
+    if (value < 0) {
+        digits[sizeof(digits) - ++length] = '-';
+    }
+
+    dx_jsonWriteRaw(writer, digits + sizeof(digits) - length, length);
+}
+
+void dx_jsonWriteBool(DX_JSON_WRITER *writer, bool value)
+{
+    if (value) {
+        dx_jsonWriteRaw(writer, "true", 4);
+    } else {
+        dx_jsonWriteRaw(writer, "false", 5);
+    }
+}
+
+// fixed point, the integer and fraction digits come from one 64 bit integer scaled by 10^precision
+static void write_fixed(DX_JSON_WRITER *writer, bool negative, uint64_t fixed, int precision)
+{
+    char digits[48];
+    char *end = digits + sizeof(digits);
+    uint64_t fraction = fixed % power_of_ten[precision];
+    char *p = end;
+
+    if (fraction != 0) {
+        int places = precision;
+
+        while (fraction % 10 == 0) {
+            fraction /= 10;
+            places--;
+        }
+
+        p -= places;
+        memset(p, '0', (size_t)places);
+        format_unsigned(end, fraction);
+        *--p = '.';
+    }
+
+    p -= format_unsigned(p, fixed / power_of_ten[precision]);
+
+    if (negative && fixed != 0) {
+        *--p = '-';
+    }
+
+    dx_jsonWriteRaw(writer, p, (size_t)(end - p));
+}
+
+void dx_jsonWriteNumber(DX_JSON_WRITER *writer, double value, int precision)
+{
+    char digits[48];
+    double scaled;
+
+    if (!isfinite(value)) {
+        dx_jsonWriteRaw(writer, "null", 4);
+        return;
+    }
+
+    if (precision < 0) {
+        precision = 0;
+    } else if (precision > JSON_MAX_PRECISION) {
+        precision = JSON_MAX_PRECISION;
+    }
+
+    scaled = fabs(value) * (double)power_of_ten[precision] + 0.5;
+
+    if (scaled < 1e18) {
+        write_fixed(writer, value < 0, (uint64_t)scaled, precision);
+    } else {
+        // outside the fixed point range, fall back to the same format parson uses
+        int length = snprintf(digits, sizeof(digits), "%1.17g", value);
+        dx_jsonWriteRaw(writer, digits, (size_t)length);
+    }
+}
+
+void dx_jsonWriteDouble(DX_JSON_WRITER *writer, double value)
+{
+    double magnitude = fabs(value);
+    char digits[32];
+    int length;
+
+    if (!isfinite(value)) {
+        dx_jsonWriteRaw(writer, "null", 4);
+        return;
+    }
+
+    if (value == 0) {
+        if (signbit(value)) {
+            dx_jsonWriteRaw(writer, "-0", 2);
+        } else {
+            dx_jsonWriteRaw(writer, "0", 1);
+        }
+        return;
+    }
+
+    // most telemetry values are short decimals, find the fewest decimal places that read back as the same double.
+    // Below 2^53 the scaled value is an exact integer and the division is correctly rounded, as strtod would be.
+    for (int precision = 0; precision <= JSON_MAX_PRECISION && magnitude * (double)power_of_ten[precision] < 9007199254740992.0;
+         precision++) {
+        double fixed = nearbyint(magnitude * (double)power_of_ten[precision]);
+
+        if (fixed / (double)power_of_ten[precision] == magnitude) {
+            write_fixed(writer, value < 0, (uint64_t)fixed, precision);
+            return;
+        }
+    }
+
+    // the same format parson uses, 17 significant digits always round trip
+    length = snprintf(digits, sizeof(digits), "%1.17g", value);
+    dx_jsonWriteRaw(writer, digits, (size_t)length);
+}
+
+static bool json_write_value(DX_JSON_WRITER *writer, DX_JSON_TYPE type, int precision, va_list *valist)
+{
+    switch (type) {
+    case DX_JSON_INT:
+        dx_jsonWriteInt(writer, va_arg(*valist, int));
+        break;
+
+        // floats are cast to doubles for valists
+    case DX_JSON_FLOAT:
+    case DX_JSON_DOUBLE:
+        if (precision > 0) {
+            dx_jsonWriteNumber(writer, va_arg(*valist, double), precision);
+        } else {
+            dx_jsonWriteDouble(writer, va_arg(*valist, double));
+        }
+        break;
+
+    case DX_JSON_STRING:
+        dx_jsonWriteString(writer, va_arg(*valist, char *));
+        break;
+
+    case DX_JSON_BOOL:
+        dx_jsonWriteBool(writer, va_arg(*valist, int));
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+bool dx_jsonWriteFields(DX_JSON_WRITER *writer, int key_value_pair_count, va_list *valist)
+{
+    bool result = true;
+
+    dx_jsonWriteRaw(writer, "{", 1);
+
+    for (int i = 0; i < key_value_pair_count && result; i++) {
+        DX_JSON_TYPE type = va_arg(*valist, int);
+        char *key = va_arg(*valist, char *);
+
+        if (i > 0) {
+            dx_jsonWriteRaw(writer, ",", 1);
+        }
+
+        dx_jsonWriteString(writer, key);
+        dx_jsonWriteRaw(writer, ":", 1);
 
-    if (strlen(json_string) < buffer_size) {
-        DX_SAFE_STRING_COPY(buffer, json_string, buffer_size);
-        result = true;
+        result = json_write_value(writer, type, 0, valist);
     }
 
-    json_free_serialized_string(json_string);
-    json_value_free(root_value);
+    dx_jsonWriteRaw(writer, "}", 1);
+
+    return result && !writer->overflow;
+}
+
+bool dx_jsonSerialize(char *buffer, size_t buffer_size, int key_value_pair_count, ...)
+{
+    DX_JSON_WRITER writer;
+    bool result;
+
+    va_list valist;
+    va_start(valist, key_value_pair_count);
+
+    dx_jsonWriterInit(&writer, buffer, buffer_size);
+    result = dx_jsonWriteFields(&writer, key_value_pair_count, &valist);
+
+    va_end(valist);
 
     return result;
-}
\ No newline at end of file
+}
+
+bool dx_jsonSchemaInit(DX_JSON_SCHEMA *schema)
+{
+    size_t keys_size = 1;
+    DX_JSON_WRITER writer;
+
+    dx_jsonSchemaFree(schema);
+
+    for (size_t i = 0; i < schema->field_count; i++) {
+        // separator, quotes and colon
+        keys_size += json_escape_length(schema->fields[i].name) + 4;
+    }
+
+    schema->__keys = (char *)malloc(keys_size);
+    schema->__key_offsets = (size_t *)malloc((schema->field_count + 1) * sizeof(size_t));
+
+    if (schema->__keys == NULL || schema->__key_offsets == NULL) {
+        dx_jsonSchemaFree(schema);
+        return false;
+    }
+
+    dx_jsonWriterInit(&writer, schema->__keys, keys_size);
+
+    for (size_t i = 0; i < schema->field_count; i++) {
+        schema->__key_offsets[i] = writer.length;
+
+        dx_jsonWriteRaw(&writer, i == 0 ? "{" : ",", 1);
+        dx_jsonWriteString(&writer, schema->fields[i].name);
+        dx_jsonWriteRaw(&writer, ":", 1);
+    }
+
+    schema->__key_offsets[schema->field_count] = writer.length;
+
+    return true;
+}
+
+void dx_jsonSchemaFree(DX_JSON_SCHEMA *schema)
+{
+    free(schema->__keys);
+    schema->__keys = NULL;
+
+    free(schema->__key_offsets);
+    schema->__key_offsets = NULL;
+}
+
+bool dx_jsonSchemaSerialize(const DX_JSON_SCHEMA *schema, char *buffer, size_t buffer_size, ...)
+{
+    DX_JSON_WRITER writer;
+    bool result = true;
+
+    if (schema->__keys == NULL) {
+        return false;
+    }
+
+    va_list valist;
+    va_start(valist, buffer_size);
+
+    dx_jsonWriterInit(&writer, buffer, buffer_size);
+
+    if (schema->field_count == 0) {
+        dx_jsonWriteRaw(&writer, "{", 1);
+    }
+
+    for (size_t i = 0; i < schema->field_count && result; i++) {
+        dx_jsonWriteRaw(&writer, schema->__keys + schema->__key_offsets[i], schema->__key_offsets[i + 1] - schema->__key_offsets[i]);
+        result = json_write_value(&writer, schema->fields[i].type, schema->fields[i].precision, &valist);
+    }
+    va_end(valist);
+
+    dx_jsonWriteRaw(&writer, "}", 1);
+
+    return result && !writer.overflow;
+}
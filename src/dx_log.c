@@ -0,0 +1,328 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#include "dx_log.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+// records written per writev
+#define LOG_FLUSH_BATCH 64
+// format strings tracked per thread for rate limiting
+#define LOG_RATE_SLOTS 32
+
+/*
+    Records are formatted in place in a bounded multi producer ring, producers claim a cell with a CAS on the enqueue
+    position and publish it by advancing the cell sequence. The flusher thread is the only consumer, it writes runs of
+    published records with one writev and then releases the cells. The flusher sleeps on a semaphore that producers only
+    post when it has announced it is idle.
+*/
+typedef struct
+{
+    atomic_size_t sequence;
+    size_t length;
+    char text[DX_LOG_RECORD_SIZE];
+} LOG_RECORD;
+
+typedef struct
+{
+    const char *fmt;
+    time_t second;
+    unsigned int count;
+} LOG_RATE_SLOT;
+
+static LOG_RECORD log_ring[DX_LOG_RING_SIZE];
+static atomic_size_t log_enqueue_pos;
+static size_t log_dequeue_pos;
+static atomic_size_t log_dropped;
+static atomic_int log_level = DX_LOG_DEBUG;
+static atomic_bool flusher_idle;
+static sem_t flusher_wake;
+static pthread_mutex_t flush_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static bool flusher_running;
+
+// timestamp prefix reformatted once per second per thread
+static __thread time_t cached_second = -1;
+static __thread char cached_stamp[16];
+static __thread LOG_RATE_SLOT rate_slots[LOG_RATE_SLOTS];
+
+_Static_assert((DX_LOG_RING_SIZE & (DX_LOG_RING_SIZE - 1)) == 0, "DX_LOG_RING_SIZE must be a power of two");
+
+static size_t log_drain(void)
+{
+    struct iovec iov[LOG_FLUSH_BATCH];
+    size_t written = 0;
+    size_t count;
+
+    pthread_mutex_lock(&flush_lock);
+
+    do
+    {
+        count = 0;
+
+        while (count < LOG_FLUSH_BATCH)
+        {
+            LOG_RECORD *record = &log_ring[(log_dequeue_pos + count) & (DX_LOG_RING_SIZE - 1)];
+
+            if (atomic_load_explicit(&record->sequence, memory_order_acquire) != log_dequeue_pos + count + 1)
+            {
+                break;
+            }
+
+            iov[count].iov_base = record->text;
+            iov[count].iov_len  = record->length;
+            count++;
+        }
+
+        if (count)
+        {
+            // keep ordering with anything written through stdio
+            fflush(stdout);
+
+            if (writev(STDOUT_FILENO, iov, (int)count) < 0)
+            {
+                // nothing useful to do if stdout has gone, the records are released regardless
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                LOG_RECORD *record = &log_ring[log_dequeue_pos & (DX_LOG_RING_SIZE - 1)];
+                atomic_store_explicit(&record->sequence, log_dequeue_pos + DX_LOG_RING_SIZE, memory_order_release);
+                log_dequeue_pos++;
+            }
+
+            written += count;
+        }
+    } while (count == LOG_FLUSH_BATCH);
+
+    size_t dropped = atomic_exchange(&log_dropped, 0);
+    if (dropped)
+    {
+        char notice[64];
+        int length = snprintf(notice, sizeof(notice), "%zu log messages dropped\n", dropped);
+        if (write(STDOUT_FILENO, notice, (size_t)length) < 0)
+        {
+        }
+    }
+
+    pthread_mutex_unlock(&flush_lock);
+
+    return written;
+}
+
+static bool log_pending(void)
+{
+    size_t pos;
+
+    // dx_logFlush can drain from another thread, the dequeue position is only read and advanced under the flush lock
+    pthread_mutex_lock(&flush_lock);
+    pos = log_dequeue_pos;
+    pthread_mutex_unlock(&flush_lock);
+
+    return atomic_load_explicit(&log_ring[pos & (DX_LOG_RING_SIZE - 1)].sequence, memory_order_acquire) == pos + 1 ||
+           atomic_load(&log_dropped) != 0;
+}
+
+static void *log_flusher(void *arg)
+{
+    for (;;)
+    {
+        log_drain();
+
+        atomic_store(&flusher_idle, true);
+
+        // a producer that published before the flag was set has not posted, so check again before sleeping
+        if (log_pending())
+        {
+            atomic_store(&flusher_idle, false);
+            continue;
+        }
+
+        while (sem_wait(&flusher_wake) != 0)
+        {
+        }
+    }
+
+    return NULL;
+}
+
+static void log_init(void)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    for (size_t i = 0; i < DX_LOG_RING_SIZE; i++)
+    {
+        atomic_init(&log_ring[i].sequence, i);
+    }
+
+    sem_init(&flusher_wake, 0, 0);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    flusher_running = pthread_create(&thread, &attr, log_flusher, NULL) == 0;
+    pthread_attr_destroy(&attr);
+
+    atexit(dx_logFlush);
+}
+
+/// <summary>
+/// Allow DX_LOG_RATE_LIMIT messages per second from a format string on this thread, a summary of suppressed messages is
+/// logged with the first message of the next second
+/// </summary>
+static bool log_rate_allowed(const char *fmt, time_t now, unsigned int *suppressed)
+{
+    LOG_RATE_SLOT *slot = &rate_slots[((uintptr_t)fmt >> 3) % LOG_RATE_SLOTS];
+
+    *suppressed = 0;
+
+    if (DX_LOG_RATE_LIMIT == 0)
+    {
+        return true;
+    }
+
+    if (slot->fmt != fmt || slot->second != now)
+    {
+        if (slot->fmt == fmt && slot->count > DX_LOG_RATE_LIMIT)
+        {
+            *suppressed = slot->count - DX_LOG_RATE_LIMIT;
+        }
+
+        slot->fmt    = fmt;
+        slot->second = now;
+        slot->count  = 0;
+    }
+
+    return ++slot->count <= DX_LOG_RATE_LIMIT;
+}
+
+static void log_write(const char *fmt, va_list args)
+{
+    struct timespec clock;
+    unsigned int suppressed;
+    LOG_RECORD *record;
+    time_t now;
+    size_t pos;
+
+    pthread_once(&log_once, log_init);
+
+    // the coarse clock is the time of the last kernel tick, read from the vDSO without a system call
+    clock_gettime(CLOCK_REALTIME_COARSE, &clock);
+    now = clock.tv_sec;
+
+    if (!log_rate_allowed(fmt, now, &suppressed))
+    {
+        return;
+    }
+
+    if (now != cached_second)
+    {
+        struct tm tm;
+        localtime_r(&now, &tm);
+        snprintf(cached_stamp, sizeof(cached_stamp), "%02d:%02d:%02d - ", tm.tm_hour, tm.tm_min, tm.tm_sec);
+        cached_second = now;
+    }
+
+    pos = atomic_load_explicit(&log_enqueue_pos, memory_order_relaxed);
+
+    for (;;)
+    {
+        record       = &log_ring[pos & (DX_LOG_RING_SIZE - 1)];
+        intptr_t dif = (intptr_t)atomic_load_explicit(&record->sequence, memory_order_acquire) - (intptr_t)pos;
+
+        if (dif == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&log_enqueue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (dif < 0)
+        {
+            atomic_fetch_add(&log_dropped, 1);
+            return;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&log_enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    int length = snprintf(record->text, sizeof(record->text), "%s", cached_stamp);
+
+    if (suppressed)
+    {
+        length += snprintf(record->text + length, sizeof(record->text) - (size_t)length, "(%u similar messages suppressed) ", suppressed);
+    }
+
+    if ((size_t)length < sizeof(record->text))
+    {
+        length += vsnprintf(record->text + length, sizeof(record->text) - (size_t)length, fmt, args);
+    }
+
+    record->length = (size_t)length < sizeof(record->text) ? (size_t)length : sizeof(record->text) - 1;
+
+    atomic_store_explicit(&record->sequence, pos + 1, memory_order_release);
+
+    if (!flusher_running)
+    {
+        log_drain();
+    }
+    else if (atomic_exchange(&flusher_idle, false))
+    {
+        sem_post(&flusher_wake);
+    }
+}
+
+void dx_Log(DX_LOG_LEVEL level, const char *fmt, ...)
+{
+    if ((int)level > atomic_load_explicit(&log_level, memory_order_relaxed))
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    log_write(fmt, args);
+    va_end(args);
+}
+
+void dx_Log_Debug(char *fmt, ...)
+{
+    if (DX_LOG_DEBUG > atomic_load_explicit(&log_level, memory_order_relaxed))
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    log_write(fmt, args);
+    va_end(args);
+}
+
+void dx_Log_Debug_Init(char *buffer, size_t buffer_size)
+{
+}
+
+void dx_logFlush(void)
+{
+    if (pthread_once(&log_once, log_init) == 0)
+    {
+        log_drain();
+    }
+}
+
+void dx_logSetLevel(DX_LOG_LEVEL level)
+{
+    atomic_store(&log_level, (int)level);
+}
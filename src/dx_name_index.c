@@ -0,0 +1,105 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#include "dx_name_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t nameHash(const char *name)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/// <summary>
+/// Returns the slot holding name, or the empty slot ending its probe run
+/// </summary>
+static size_t findSlot(const DX_NAME_INDEX *index, const char *name, uint32_t hash, DX_NAME_INDEX_NAME_OF nameOf, void *context)
+{
+    size_t mask = index->size - 1;
+    size_t slot = hash & mask;
+
+    while (index->slots[slot] != 0) {
+        if (index->hashes[slot] == hash && strcmp(nameOf(index->slots[slot] - 1, context), name) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+void dx_nameIndexFree(DX_NAME_INDEX *index)
+{
+    free(index->slots);
+    free(index->hashes);
+    free(index->chain);
+    index->slots = NULL;
+    index->hashes = NULL;
+    index->chain = NULL;
+    index->size = 0;
+}
+
+bool dx_nameIndexBuild(DX_NAME_INDEX *index, size_t itemCount, DX_NAME_INDEX_NAME_OF nameOf, void *context, bool chainDuplicates)
+{
+    size_t size = 8;
+
+    dx_nameIndexFree(index);
+
+    while (size < itemCount * 2) {
+        size <<= 1;
+    }
+
+    index->slots = (size_t *)calloc(size, sizeof(size_t));
+    index->hashes = (uint32_t *)malloc(size * sizeof(uint32_t));
+    if (chainDuplicates) {
+        index->chain = (size_t *)calloc(itemCount + 1, sizeof(size_t));
+    }
+
+    if (index->slots == NULL || index->hashes == NULL || (chainDuplicates && index->chain == NULL)) {
+        dx_nameIndexFree(index);
+        return false;
+    }
+
+    index->size = size;
+
+    for (size_t i = 0; i < itemCount; i++) {
+        const char *name = nameOf(i, context);
+        uint32_t hash = nameHash(name);
+        size_t slot = findSlot(index, name, hash, nameOf, context);
+
+        if (index->slots[slot] == 0) {
+            index->slots[slot] = i + 1;
+            index->hashes[slot] = hash;
+        } else if (index->chain != NULL) {
+            // same name, append to the chain
+            size_t last = index->slots[slot];
+            while (index->chain[last] != 0) {
+                last = index->chain[last];
+            }
+            index->chain[last] = i + 1;
+        }
+    }
+
+    return true;
+}
+
+size_t dx_nameIndexFind(const DX_NAME_INDEX *index, const char *name, DX_NAME_INDEX_NAME_OF nameOf, void *context)
+{
+    if (index->size == 0) {
+        return 0;
+    }
+
+    return index->slots[findSlot(index, name, nameHash(name), nameOf, context)];
+}
+
+size_t dx_nameIndexNext(const DX_NAME_INDEX *index, size_t entry)
+{
+    return index->chain != NULL ? index->chain[entry] : 0;
+}
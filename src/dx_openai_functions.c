@@ -2,10 +2,10 @@
    Licensed under the MIT License. */
 
 #include "dx_openai_functions.h"
+#include "dx_http.h"
 #include "parson.h"
 #include "string.h"
 #include <curl/curl.h>
-#include <curl/easy.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,120 +13,279 @@
 
 static const char *openai_endpoint = "https://api.openai.com/v1/chat/completions";
 
-// Curl stuff.
-struct MemoryStruct
+static void parse_response(DX_OPENAI_FUNCTION_CTX *ctx, const char *response);
+
+static void post_response_handler(bool succeeded, long httpStatus, const char *body, size_t bodyLength, void *context)
+{
+    // fail the request if the HTTP code returned is equal to or larger than 400
+    parse_response((DX_OPENAI_FUNCTION_CTX *)context, succeeded && httpStatus < 400 ? body : NULL);
+}
+
+// Posts on the shared async HTTP client, the connection to the endpoint is reused across requests and the response is
+// parsed on the event loop when it arrives
+static bool postHttpData(DX_OPENAI_FUNCTION_CTX *ctx, const char *url, long timeout, const char *postData)
+{
+#if defined(DUMMY_OPENAI_FUNCTION_RESPONSE)
+    const char dummy_response[] = "{\"id\":\"chatcmpl-7mfQxsDXGMqKuxb78oCmWrfZfncL0\",\"object\":\"chat.completion\",\"created\":1691833371,\"model\":\"gpt-3.5-turbo-0613\",\"choices\":[{\"index\":0,\"message\":{\"role\":\"assistant\",\"content\":null,\"function_call\":{\"name\":\"set_light_state\",\"arguments\":\"{\\n  \\\"device\\\": \\\"Lounge\\\",\\n  \\\"state\\\": \\\"on\\\",\\n  \\\"color\\\": \\\"blue\\\"\\n}\"}},\"finish_reason\":\"function_call\"}],\"usage\":{\"prompt_tokens\":376,\"completion_tokens\":31,\"total_tokens\":407}  }";
+
+    post_response_handler(true, 200, dummy_response, sizeof(dummy_response) - 1, ctx);
+
+    return true;
+#endif // DUMMY_OPENAI_FUNCTION_RESPONSE
+
+    DX_HTTP_REQUEST request = {
+        .url = url,
+        .headers = ctx->headers,
+        .postData = postData,
+        .timeoutSeconds = timeout,
+        .responseHandler = post_response_handler,
+        .context = ctx,
+    };
+
+    return dx_httpRequestAsync(&request);
+}
+
+#if !defined(DUMMY_OPENAI_FUNCTION_RESPONSE)
+// Streaming responses arrive as server-sent events, one "data: {chunk}" line per delta terminated by "data: [DONE]"
+typedef struct
 {
-    char *memory;
+    char *data;
+    size_t length;
     size_t size;
-};
+} STREAM_BUFFER;
 
-static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, void *userp)
+typedef struct
+{
+    DX_OPENAI_FUNCTION_CTX *ctx;
+    STREAM_BUFFER line;
+    STREAM_BUFFER content;
+    STREAM_BUFFER function_call_name;
+    STREAM_BUFFER function_call_arguments;
+    char finish_reason[32];
+    // scanner state for the streamed arguments, they are complete when the outer object closes
+    int arguments_depth;
+    bool arguments_in_string;
+    bool arguments_escape;
+    bool arguments_complete;
+    bool handler_called;
+} STREAM_STATE;
+
+static bool stream_buffer_append(STREAM_BUFFER *buffer, const char *data, size_t length)
 {
-    size_t realsize = size * nmemb;
-    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
+    if (buffer->length + length + 1 > buffer->size)
+    {
+        size_t size = buffer->size ? buffer->size : 128;
+        while (size < buffer->length + length + 1)
+        {
+            size *= 2;
+        }
+
+        char *ptr = realloc(buffer->data, size);
+        if (!ptr)
+        {
+            return false;
+        }
+        buffer->data = ptr;
+        buffer->size = size;
+    }
+
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = 0;
+
+    return true;
+}
 
-    char *ptr = realloc(mem->memory, mem->size + realsize + 1);
-    if (!ptr)
+static void stream_call_handler(STREAM_STATE *state)
+{
+    if (state->handler_called)
     {
-        /* out of memory! */
-        printf("not enough memory (realloc returned NULL)\n");
-        return 0;
+        return;
     }
 
-    mem->memory = ptr;
-    memcpy(&(mem->memory[mem->size]), contents, realsize);
-    mem->size += realsize;
-    mem->memory[mem->size] = 0;
+    state->handler_called = true;
 
-    return realsize;
+    if (state->ctx->openai_function_handler)
+    {
+        state->ctx->openai_function_handler(state->content.data, state->finish_reason[0] ? state->finish_reason : NULL,
+                                            state->function_call_name.data, state->function_call_arguments.data);
+    }
 }
 
-// https://curl.se/libcurl/c/getinmemory.html
-static char *postHttpData(DX_OPENAI_FUNCTION_CTX *ctx, const char *url, long timeout, const char *postData)
+/// <summary>
+/// Track brace depth of the streamed function call arguments, the call can be made as soon as the object closes
+/// rather than waiting for the finish_reason chunk and the end of the stream
+/// </summary>
+static void stream_scan_arguments(STREAM_STATE *state, const char *fragment)
 {
-    CURL *curl_handle;
-    CURLcode res;
-    static bool curl_initialized = false;
-    struct curl_slist *headers = ctx->headers;
+    for (; *fragment && !state->arguments_complete; fragment++)
+    {
+        if (state->arguments_in_string)
+        {
+            if (state->arguments_escape)
+            {
+                state->arguments_escape = false;
+            }
+            else if (*fragment == '\\')
+            {
+                state->arguments_escape = true;
+            }
+            else if (*fragment == '"')
+            {
+                state->arguments_in_string = false;
+            }
+        }
+        else if (*fragment == '"')
+        {
+            state->arguments_in_string = true;
+        }
+        else if (*fragment == '{')
+        {
+            state->arguments_depth++;
+        }
+        else if (*fragment == '}' && --state->arguments_depth == 0)
+        {
+            state->arguments_complete = true;
+        }
+    }
+}
 
-#if defined(DUMMY_OPENAI_FUNCTION_RESPONSE)
-    const char dummy_response[] = "{\"id\":\"chatcmpl-7mfQxsDXGMqKuxb78oCmWrfZfncL0\",\"object\":\"chat.completion\",\"created\":1691833371,\"model\":\"gpt-3.5-turbo-0613\",\"choices\":[{\"index\":0,\"message\":{\"role\":\"assistant\",\"content\":null,\"function_call\":{\"name\":\"set_light_state\",\"arguments\":\"{\\n  \\\"device\\\": \\\"Lounge\\\",\\n  \\\"state\\\": \\\"on\\\",\\n  \\\"color\\\": \\\"blue\\\"\\n}\"}},\"finish_reason\":\"function_call\"}],\"usage\":{\"prompt_tokens\":376,\"completion_tokens\":31,\"total_tokens\":407}  }";
-    int len = sizeof(dummy_response) + 1;
+static void stream_parse_event(STREAM_STATE *state, const char *event)
+{
+    JSON_Value *root_value = NULL;
+    JSON_Object *choice = NULL;
+    const char *value = NULL;
 
-    char *response_copy = malloc(len);
-    if (!response_copy)
+    if (strcmp(event, "[DONE]") == 0)
     {
-        return NULL;
+        stream_call_handler(state);
+        return;
     }
 
-    memset(response_copy, 0, len);
-    memcpy(response_copy, dummy_response, len);
-    
-    return response_copy;
-#endif // DUMMY_OPENAI_FUNCTION_RESPONSE
+    if ((root_value = json_parse_string(event)) == NULL)
+    {
+        return;
+    }
 
-    if (!curl_initialized)
+    choice = json_array_get_object(json_object_get_array(json_value_get_object(root_value), "choices"), 0);
+    if (choice == NULL)
     {
-        curl_global_init(CURL_GLOBAL_ALL);
-        curl_initialized = true;
+        goto cleanup;
     }
 
-    struct MemoryStruct chunk;
+    if ((value = json_object_dotget_string(choice, "delta.content")) != NULL)
+    {
+        stream_buffer_append(&state->content, value, strlen(value));
+    }
 
-    chunk.memory = malloc(1); /* will be grown as needed by the realloc above */
-    chunk.size = 0;           /* no data at this point */
+    if ((value = json_object_dotget_string(choice, "delta.function_call.name")) != NULL)
+    {
+        stream_buffer_append(&state->function_call_name, value, strlen(value));
+    }
 
-    /* init the curl session */
-    curl_handle = curl_easy_init();
+    if ((value = json_object_dotget_string(choice, "delta.function_call.arguments")) != NULL)
+    {
+        stream_buffer_append(&state->function_call_arguments, value, strlen(value));
+        stream_scan_arguments(state, value);
+    }
 
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
+    if ((value = json_object_get_string(choice, "finish_reason")) != NULL)
+    {
+        strncpy(state->finish_reason, value, sizeof(state->finish_reason) - 1);
+        stream_call_handler(state);
+    }
+    else if (state->arguments_complete && state->function_call_name.data)
+    {
+        strncpy(state->finish_reason, "function_call", sizeof(state->finish_reason) - 1);
+        stream_call_handler(state);
+    }
 
-    /* specify URL to post */
-    curl_easy_setopt(curl_handle, CURLOPT_URL, url);
+cleanup:
+    json_value_free(root_value);
+}
 
-    /* use a CURLOPT_POSTFIELDS to fetch data */
-    curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, postData);
+static bool stream_data_handler(const char *data, size_t length, void *context)
+{
+    STREAM_STATE *state = (STREAM_STATE *)context;
 
-    /* Set timeout */
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, timeout);
+    for (size_t i = 0; i < length; i++)
+    {
+        if (data[i] != '\n')
+        {
+            if (data[i] != '\r' && !stream_buffer_append(&state->line, &data[i], 1))
+            {
+                return false;
+            }
+            continue;
+        }
 
-    /* send all data to this function  */
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
+        // once the handler has been called the rest of the stream is drained so the connection can be reused
+        if (!state->handler_called && state->line.length > 6 && strncmp(state->line.data, "data: ", 6) == 0)
+        {
+            stream_parse_event(state, state->line.data + 6);
+        }
 
-    /* we pass our 'chunk' struct to the openai_function_handler function */
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)&chunk);
+        state->line.length = 0;
+    }
 
-    /* some servers do not like requests that are made without a user-agent
-       field, so we provide one */
-    curl_easy_setopt(curl_handle, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    return true;
+}
 
-    // based on the libcurl sample - https://curl.se/libcurl/c/https.html
-    curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYPEER, 0L);
+static void stream_response_handler(bool succeeded, long httpStatus, const char *body, size_t bodyLength, void *context)
+{
+    STREAM_STATE *state = (STREAM_STATE *)context;
 
-    // https://curl.se/libcurl/c/CURLOPT_NOSIGNAL.html
-    curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1L);
+    if (!state->handler_called)
+    {
+        if (!succeeded || httpStatus >= 400)
+        {
+            // report the failure the same way as a non streamed request
+            state->handler_called = true;
+            parse_response(state->ctx, NULL);
+        }
+        else
+        {
+            // stream ended without [DONE], report what was received
+            stream_call_handler(state);
+        }
+    }
 
-    /* disable progress meter, set to 0L to enable it */
-    curl_easy_setopt(curl_handle, CURLOPT_NOPROGRESS, 1L);
+    free(state->line.data);
+    free(state->content.data);
+    free(state->function_call_name.data);
+    free(state->function_call_arguments.data);
+    free(state);
+}
 
-    // A long parameter set to 1 tells the library to fail the request if the HTTP code returned is equal to
-    // or larger than 400
-    curl_easy_setopt(curl_handle, CURLOPT_FAILONERROR, 1L);
+static bool postHttpDataStream(DX_OPENAI_FUNCTION_CTX *ctx, const char *url, long timeout, const char *postData)
+{
+    STREAM_STATE *state = calloc(1, sizeof(STREAM_STATE));
+    if (!state)
+    {
+        return false;
+    }
 
-    /* get it! */
-    res = curl_easy_perform(curl_handle);
+    state->ctx = ctx;
 
-    curl_easy_cleanup(curl_handle);
+    DX_HTTP_REQUEST request = {
+        .url = url,
+        .headers = ctx->headers,
+        .postData = postData,
+        .timeoutSeconds = timeout,
+        .dataHandler = stream_data_handler,
+        .responseHandler = stream_response_handler,
+        .context = state,
+    };
 
-    if (res == CURLE_OK)
+    if (!dx_httpRequestAsync(&request))
     {
-        // caller is responsible for freeing this.
-        return chunk.memory;
+        free(state);
+        return false;
     }
 
-    free(chunk.memory);
-    return NULL;
+    return true;
 }
+#endif // DUMMY_OPENAI_FUNCTION_RESPONSE
 
 static void del_existing_msgs(JSON_Array *message_array, const char *key)
 {
@@ -240,6 +399,7 @@ void dx_openai_function_post_request(DX_OPENAI_FUNCTION_CTX *ctx)
 
     json_object_set_number(root_object, "temperature", ctx->temperature);
     json_object_set_number(root_object, "max_tokens", ctx->max_tokens);
+    json_object_set_boolean(root_object, "stream", ctx->stream);
 
     JSON_Array *message_array = json_object_get_array(root_object, "messages");
     if (message_array == NULL)
@@ -274,17 +434,23 @@ void dx_openai_function_post_request(DX_OPENAI_FUNCTION_CTX *ctx)
 
     char *json = json_serialize_to_string(ctx->json_root);
 
-    char *response = postHttpData(ctx, openai_endpoint, 5, json);
-
-    json_free_serialized_string(json);
-
-    parse_response(ctx, response);
-
-    if (response)
+    // postData is copied by the HTTP client so the serialized string can be freed once the request is started
+#if !defined(DUMMY_OPENAI_FUNCTION_RESPONSE)
+    if (ctx->stream)
     {
-        free(response);
-        response = NULL;
+        if (!postHttpDataStream(ctx, openai_endpoint, 30, json))
+        {
+            parse_response(ctx, NULL);
+        }
     }
+    else
+#endif // DUMMY_OPENAI_FUNCTION_RESPONSE
+    if (!postHttpData(ctx, openai_endpoint, 5, json))
+    {
+        parse_response(ctx, NULL);
+    }
+
+    json_free_serialized_string(json);
 }
 
 void dx_openai_function_init(DX_OPENAI_FUNCTION_CTX *ctx, const char *filename, const char *openai_api_key)
@@ -0,0 +1,442 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#include "dx_telemetry_spool.h"
+
+#include "dx_timer.h"
+#include "dx_utilities.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SPOOL_MAGIC 0x4C4F4F53 // "SOOL"
+#define SPOOL_VERSION 1
+#define SPOOL_HEADER_SIZE 4096
+#define SPOOL_DRAIN_PERIOD_MS 100
+
+/*
+   File layout: one page header followed by a ring of records. head and tail are logical byte offsets that only ever
+   increase, the ring position is offset % capacity. Records are a uint32_t length followed by the record body:
+       uint32_t payload length, uint16_t property count,
+       content encoding\0, content type\0, (key\0 value\0) * property count, payload
+   head is only advanced after the record is written, tail is the checkpoint of records acknowledged by IoT Hub.
+*/
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t head;
+    uint64_t tail;
+} SPOOL_HEADER;
+
+static DX_DECLARE_TIMER_HANDLER(SpoolDrainHandler);
+static DX_TIMER_BINDING spoolDrainTimer = {.name = "spoolDrainTimer", .handler = SpoolDrainHandler};
+
+static int spoolFd = -1;
+static uint8_t *spoolMap = NULL;
+static size_t spoolMapSize = 0;
+static SPOOL_HEADER *spoolHeader = NULL;
+static uint8_t *spoolRing = NULL;
+
+static unsigned int drainRatePerSecond = 10;
+static unsigned int drainCreditMilli = 0;
+static unsigned int maxInFlight = DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT;
+
+// replay cursor, records between tail and readOffset are in flight
+static uint64_t readOffset = 0;
+static uint64_t inFlightEnd[DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT];
+static bool inFlightAcked[DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT];
+static unsigned int inFlightFirst = 0;
+static unsigned int inFlightCount = 0;
+static unsigned int inFlightGeneration = 0;
+
+static uint8_t *recordBuffer = NULL;
+static size_t recordBufferSize = 0;
+
+// the send context packs the in-flight slot into its low 8 bits, the generation into the rest
+_Static_assert(DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT <= 256, "DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT must fit the 8 bit slot of the send context");
+
+static void ring_write(uint64_t offset, const void *data, size_t length)
+{
+    size_t pos = (size_t)(offset % spoolHeader->capacity);
+    size_t first = spoolHeader->capacity - pos < length ? spoolHeader->capacity - pos : length;
+
+    memcpy(spoolRing + pos, data, first);
+    memcpy(spoolRing, (const uint8_t *)data + first, length - first);
+}
+
+static void ring_read(uint64_t offset, void *data, size_t length)
+{
+    size_t pos = (size_t)(offset % spoolHeader->capacity);
+    size_t first = spoolHeader->capacity - pos < length ? spoolHeader->capacity - pos : length;
+
+    memcpy(data, spoolRing + pos, first);
+    memcpy((uint8_t *)data + first, spoolRing, length - first);
+}
+
+static void checkpoint(void)
+{
+    msync(spoolMap, SPOOL_HEADER_SIZE, MS_ASYNC);
+}
+
+bool dx_telemetrySpoolIsOpen(void)
+{
+    return spoolHeader != NULL;
+}
+
+size_t dx_telemetrySpoolPendingBytes(void)
+{
+    return spoolHeader != NULL ? (size_t)(spoolHeader->head - spoolHeader->tail) : 0;
+}
+
+bool dx_telemetrySpoolOpen(DX_TELEMETRY_SPOOL_CONFIG *config)
+{
+    struct stat st;
+
+    if (spoolHeader != NULL) {
+        return true;
+    }
+
+    if (config == NULL || dx_isStringNullOrEmpty(config->path) || config->capacity < 1024) {
+        dx_Log_Debug("ERROR: Invalid telemetry spool configuration\n");
+        return false;
+    }
+
+    if ((spoolFd = open(config->path, O_RDWR | O_CREAT, 0600)) == -1) {
+        dx_Log_Debug("ERROR: Unable to open telemetry spool %s\n", config->path);
+        return false;
+    }
+
+    spoolMapSize = SPOOL_HEADER_SIZE + config->capacity;
+
+    if (fstat(spoolFd, &st) == -1 || (st.st_size != 0 && (size_t)st.st_size != spoolMapSize) || ftruncate(spoolFd, (off_t)spoolMapSize) == -1) {
+        dx_Log_Debug("ERROR: Telemetry spool %s size does not match the configured capacity\n", config->path);
+        goto cleanup;
+    }
+
+    if ((spoolMap = mmap(NULL, spoolMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, spoolFd, 0)) == MAP_FAILED) {
+        spoolMap = NULL;
+        dx_Log_Debug("ERROR: Unable to map telemetry spool %s\n", config->path);
+        goto cleanup;
+    }
+
+    spoolHeader = (SPOOL_HEADER *)spoolMap;
+    spoolRing = spoolMap + SPOOL_HEADER_SIZE;
+
+    if (spoolHeader->magic != SPOOL_MAGIC || spoolHeader->version != SPOOL_VERSION || spoolHeader->capacity != config->capacity ||
+        spoolHeader->tail > spoolHeader->head || spoolHeader->head - spoolHeader->tail > spoolHeader->capacity) {
+        memset(spoolHeader, 0x00, sizeof(SPOOL_HEADER));
+        spoolHeader->magic = SPOOL_MAGIC;
+        spoolHeader->version = SPOOL_VERSION;
+        spoolHeader->capacity = config->capacity;
+        msync(spoolMap, SPOOL_HEADER_SIZE, MS_SYNC);
+    }
+
+    drainRatePerSecond = config->drainRatePerSecond == 0 ? 10 : config->drainRatePerSecond;
+    maxInFlight = (config->maxInFlight == 0 || config->maxInFlight > DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT) ? DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT : config->maxInFlight;
+
+    readOffset = spoolHeader->tail;
+    inFlightFirst = inFlightCount = 0;
+    drainCreditMilli = 0;
+
+    dx_timerStart(&spoolDrainTimer);
+    dx_telemetrySpoolResume();
+
+    return true;
+
+cleanup:
+    close(spoolFd);
+    spoolFd = -1;
+    spoolHeader = NULL;
+    return false;
+}
+
+void dx_telemetrySpoolClose(void)
+{
+    if (spoolHeader == NULL) {
+        return;
+    }
+
+    dx_timerStop(&spoolDrainTimer);
+
+    // replayed messages still awaiting acknowledgement are ignored, they remain in the spool and are replayed on reopen
+    inFlightGeneration++;
+    inFlightCount = 0;
+
+    msync(spoolMap, spoolMapSize, MS_SYNC);
+    munmap(spoolMap, spoolMapSize);
+    close(spoolFd);
+
+    spoolMap = NULL;
+    spoolHeader = NULL;
+    spoolRing = NULL;
+    spoolFd = -1;
+
+    if (recordBuffer != NULL) {
+        free(recordBuffer);
+        recordBuffer = NULL;
+        recordBufferSize = 0;
+    }
+}
+
+bool dx_telemetrySpoolAppend(const void *message, size_t messageLength, DX_MESSAGE_PROPERTY **messageProperties, size_t messagePropertyCount,
+                             DX_MESSAGE_CONTENT_PROPERTIES *messageContentProperties)
+{
+    const char *contentEncoding = "";
+    const char *contentType = "";
+    uint16_t propertyCount = 0;
+    uint32_t payloadLength = (uint32_t)messageLength;
+    uint32_t recordLength;
+    uint64_t offset;
+    size_t length;
+
+    if (spoolHeader == NULL || message == NULL || messageLength == 0 || messageLength > UINT32_MAX) {
+        return false;
+    }
+
+    if (messageContentProperties != NULL) {
+        contentEncoding = messageContentProperties->contentEncoding != NULL ? messageContentProperties->contentEncoding : "";
+        contentType = messageContentProperties->contentType != NULL ? messageContentProperties->contentType : "";
+    }
+
+    length = sizeof(payloadLength) + sizeof(propertyCount) + strlen(contentEncoding) + 1 + strlen(contentType) + 1 + messageLength;
+
+    for (size_t i = 0; messageProperties != NULL && i < messagePropertyCount && propertyCount < DX_TELEMETRY_SPOOL_MAX_PROPERTIES; i++) {
+        if (!dx_isStringNullOrEmpty(messageProperties[i]->key) && !dx_isStringNullOrEmpty(messageProperties[i]->value)) {
+            length += strlen(messageProperties[i]->key) + 1 + strlen(messageProperties[i]->value) + 1;
+            propertyCount++;
+        }
+    }
+
+    if (length > UINT32_MAX || sizeof(recordLength) + length > spoolHeader->capacity - (spoolHeader->head - spoolHeader->tail)) {
+        dx_Log_Debug("Telemetry spool full, message dropped\n");
+        return false;
+    }
+
+    recordLength = (uint32_t)length;
+    offset = spoolHeader->head;
+
+    ring_write(offset, &recordLength, sizeof(recordLength));
+    offset += sizeof(recordLength);
+    ring_write(offset, &payloadLength, sizeof(payloadLength));
+    offset += sizeof(payloadLength);
+    ring_write(offset, &propertyCount, sizeof(propertyCount));
+    offset += sizeof(propertyCount);
+    ring_write(offset, contentEncoding, strlen(contentEncoding) + 1);
+    offset += strlen(contentEncoding) + 1;
+    ring_write(offset, contentType, strlen(contentType) + 1);
+    offset += strlen(contentType) + 1;
+
+    for (size_t i = 0, count = 0; messageProperties != NULL && i < messagePropertyCount && count < propertyCount; i++) {
+        if (!dx_isStringNullOrEmpty(messageProperties[i]->key) && !dx_isStringNullOrEmpty(messageProperties[i]->value)) {
+            ring_write(offset, messageProperties[i]->key, strlen(messageProperties[i]->key) + 1);
+            offset += strlen(messageProperties[i]->key) + 1;
+            ring_write(offset, messageProperties[i]->value, strlen(messageProperties[i]->value) + 1);
+            offset += strlen(messageProperties[i]->value) + 1;
+            count++;
+        }
+    }
+
+    ring_write(offset, message, messageLength);
+    offset += messageLength;
+
+    // publish the record only once it is completely written
+    spoolHeader->head = offset;
+    checkpoint();
+
+    return true;
+}
+
+static void AdvanceTail(void)
+{
+    while (inFlightCount > 0 && inFlightAcked[inFlightFirst]) {
+        inFlightAcked[inFlightFirst] = false;
+        spoolHeader->tail = inFlightEnd[inFlightFirst];
+        inFlightFirst = (inFlightFirst + 1) % DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT;
+        inFlightCount--;
+    }
+
+    checkpoint();
+}
+
+/// <summary>
+/// IoT Hub acknowledged (or failed) a replayed record. Advance the checkpoint over the acknowledged prefix,
+/// on failure rewind the replay cursor to the checkpoint so the unacknowledged records are sent again.
+/// </summary>
+static void SpoolPublishComplete(bool delivered, void *context)
+{
+    unsigned int generation = (unsigned int)((uintptr_t)context >> 8);
+    unsigned int slot = (unsigned int)((uintptr_t)context & 0xFF);
+
+    if (spoolHeader == NULL || generation != (inFlightGeneration & 0xFFFFFF)) {
+        return;
+    }
+
+    if (!delivered) {
+        inFlightGeneration++;
+        inFlightCount = 0;
+        readOffset = spoolHeader->tail;
+        return;
+    }
+
+    inFlightAcked[slot] = true;
+    AdvanceTail();
+}
+
+/// <summary>
+/// The header checkpoint is written asynchronously, after a crash head can be ahead of the record data. Everything from
+/// the replay cursor to head is discarded, it is queued as an already acknowledged slot so the tail only moves past it
+/// once the records in flight before it are acknowledged.
+/// </summary>
+static void DiscardCorruptRecords(void)
+{
+    unsigned int slot = (inFlightFirst + inFlightCount) % DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT;
+
+    dx_Log_Debug("ERROR: Telemetry spool record at offset %llu is corrupt, discarding %llu bytes\n", (unsigned long long)readOffset,
+                 (unsigned long long)(spoolHeader->head - readOffset));
+
+    readOffset = spoolHeader->head;
+    inFlightEnd[slot] = readOffset;
+    inFlightAcked[slot] = true;
+    inFlightCount++;
+
+    AdvanceTail();
+}
+
+// next null terminated string in the record, NULL if it runs past end
+static char *RecordString(char **cursor, const char *end)
+{
+    char *string = *cursor;
+    char *terminator = string < end ? memchr(string, 0, (size_t)(end - string)) : NULL;
+
+    if (terminator != NULL) {
+        *cursor = terminator + 1;
+    }
+    return terminator != NULL ? string : NULL;
+}
+
+static bool ReplayRecord(void)
+{
+    DX_MESSAGE_PROPERTY properties[DX_TELEMETRY_SPOOL_MAX_PROPERTIES];
+    DX_MESSAGE_PROPERTY *propertyPointers[DX_TELEMETRY_SPOOL_MAX_PROPERTIES];
+    DX_MESSAGE_CONTENT_PROPERTIES contentProperties;
+    uint64_t available = spoolHeader->head - readOffset;
+    uint32_t recordLength, payloadLength;
+    uint16_t propertyCount;
+    unsigned int slot;
+    char *cursor, *end;
+
+    if (available < sizeof(recordLength)) {
+        DiscardCorruptRecords();
+        return false;
+    }
+
+    ring_read(readOffset, &recordLength, sizeof(recordLength));
+
+    // payload length, property count and the two content property terminators
+    if (recordLength < sizeof(payloadLength) + sizeof(propertyCount) + 2 || recordLength > available - sizeof(recordLength) ||
+        recordLength > spoolHeader->capacity) {
+        DiscardCorruptRecords();
+        return false;
+    }
+
+    if (recordLength > recordBufferSize) {
+        uint8_t *buffer = realloc(recordBuffer, recordLength);
+        if (buffer == NULL) {
+            return false;
+        }
+        recordBuffer = buffer;
+        recordBufferSize = recordLength;
+    }
+
+    ring_read(readOffset + sizeof(recordLength), recordBuffer, recordLength);
+
+    memcpy(&payloadLength, recordBuffer, sizeof(payloadLength));
+    memcpy(&propertyCount, recordBuffer + sizeof(payloadLength), sizeof(propertyCount));
+
+    cursor = (char *)recordBuffer + sizeof(payloadLength) + sizeof(propertyCount);
+    end = (char *)recordBuffer + recordLength;
+
+    contentProperties.contentEncoding = RecordString(&cursor, end);
+    contentProperties.contentType = RecordString(&cursor, end);
+
+    if (contentProperties.contentEncoding == NULL || contentProperties.contentType == NULL || propertyCount > DX_TELEMETRY_SPOOL_MAX_PROPERTIES) {
+        DiscardCorruptRecords();
+        return false;
+    }
+
+    for (uint16_t i = 0; i < propertyCount; i++) {
+        properties[i].key = RecordString(&cursor, end);
+        properties[i].value = RecordString(&cursor, end);
+        if (properties[i].key == NULL || properties[i].value == NULL) {
+            DiscardCorruptRecords();
+            return false;
+        }
+        propertyPointers[i] = &properties[i];
+    }
+
+    // the payload is the rest of the record
+    if (payloadLength != (uint32_t)(end - cursor)) {
+        DiscardCorruptRecords();
+        return false;
+    }
+
+    slot = (inFlightFirst + inFlightCount) % DX_TELEMETRY_SPOOL_MAX_IN_FLIGHT;
+
+    if (!dx_azurePublishStaged(cursor, payloadLength, propertyPointers, propertyCount, &contentProperties, SpoolPublishComplete,
+                               (void *)(uintptr_t)(((inFlightGeneration & 0xFFFFFF) << 8) | slot))) {
+        return false;
+    }
+
+    readOffset += sizeof(recordLength) + recordLength;
+    inFlightEnd[slot] = readOffset;
+    inFlightAcked[slot] = false;
+    inFlightCount++;
+
+    return true;
+}
+
+/// <summary>
+/// Replays spooled records at drainRatePerSecond while connected. Replay stops when the publish window closes
+/// or maxInFlight records are awaiting acknowledgement so live telemetry is not starved.
+/// </summary>
+static DX_TIMER_HANDLER(SpoolDrainHandler)
+{
+    if (spoolHeader == NULL || spoolHeader->head == spoolHeader->tail) {
+        drainCreditMilli = 0;
+        return;
+    }
+
+    // wait for dx_telemetrySpoolResume when the connection is re-established
+    if (!dx_isAzureConnected()) {
+        drainCreditMilli = 0;
+        return;
+    }
+
+    drainCreditMilli += drainRatePerSecond * SPOOL_DRAIN_PERIOD_MS;
+    if (drainCreditMilli > drainRatePerSecond * 1000) {
+        drainCreditMilli = drainRatePerSecond * 1000;
+    }
+
+    while (drainCreditMilli >= 1000 && readOffset < spoolHeader->head && inFlightCount < maxInFlight && dx_azureIsPublishWindowOpen()) {
+        if (!ReplayRecord()) {
+            break;
+        }
+        drainCreditMilli -= 1000;
+    }
+
+    dx_timerOneShotSet(&spoolDrainTimer, &(struct timespec){0, SPOOL_DRAIN_PERIOD_MS * ONE_MS});
+}
+DX_TIMER_HANDLER_END
+
+void dx_telemetrySpoolResume(void)
+{
+    if (spoolHeader != NULL && spoolHeader->head != spoolHeader->tail) {
+        dx_timerOneShotSet(&spoolDrainTimer, &(struct timespec){0, 0});
+    }
+}
@@ -3,12 +3,288 @@
    
 #include "dx_timer.h"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 
+/*
+	Hierarchical timer wheel for timers with a tolerance. Level 0 has one slot per tick, each higher level slot covers a
+	whole revolution of the level below and is cascaded down as the wheel turns. Insert and cancel are O(1) list
+	operations and one libuv timer drives the wheel, armed for the next occupied level 0 slot or cascade.
+*/
+#define WHEEL_LEVELS 4
+#define WHEEL_L0_BITS 8
+#define WHEEL_LN_BITS 6
+#define WHEEL_L0_SIZE (1 << WHEEL_L0_BITS)
+#define WHEEL_LN_SIZE (1 << WHEEL_LN_BITS)
+#define WHEEL_MAX_TICKS ((1ULL << (WHEEL_L0_BITS + (WHEEL_LEVELS - 1) * WHEEL_LN_BITS)) - 1)
+
+#define container_of(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+
+static DX_TIMER_WHEEL_NODE wheel_l0[WHEEL_L0_SIZE];
+static DX_TIMER_WHEEL_NODE wheel_ln[WHEEL_LEVELS - 1][WHEEL_LN_SIZE];
+static uint64_t wheel_now;
+static size_t wheel_count;
+static bool wheel_initialized;
+static uv_timer_t wheel_driver;
+
+static void wheel_list_init(DX_TIMER_WHEEL_NODE *head)
+{
+	head->next = head;
+	head->prev = head;
+}
+
+static void wheel_list_add(DX_TIMER_WHEEL_NODE *head, DX_TIMER_WHEEL_NODE *node)
+{
+	node->next       = head;
+	node->prev       = head->prev;
+	head->prev->next = node;
+	head->prev       = node;
+}
+
+static void wheel_list_remove(DX_TIMER_WHEEL_NODE *node)
+{
+	node->prev->next = node->next;
+	node->next->prev = node->prev;
+	node->next       = NULL;
+	node->prev       = NULL;
+}
+
+static void wheel_list_move(DX_TIMER_WHEEL_NODE *from, DX_TIMER_WHEEL_NODE *to)
+{
+	wheel_list_init(to);
+
+	if (from->next != from)
+	{
+		to->next       = from->next;
+		to->prev       = from->prev;
+		to->next->prev = to;
+		to->prev->next = to;
+		wheel_list_init(from);
+	}
+}
+
+static void wheel_init(void)
+{
+	for (int i = 0; i < WHEEL_L0_SIZE; i++)
+	{
+		wheel_list_init(&wheel_l0[i]);
+	}
+
+	for (int level = 0; level < WHEEL_LEVELS - 1; level++)
+	{
+		for (int i = 0; i < WHEEL_LN_SIZE; i++)
+		{
+			wheel_list_init(&wheel_ln[level][i]);
+		}
+	}
+
+	uv_timer_init(uv_default_loop(), &wheel_driver);
+	wheel_now         = uv_now(uv_default_loop()) / DX_TIMER_WHEEL_TICK_MS;
+	wheel_initialized = true;
+}
+
+/// <summary>
+/// The expiry tick of the deadline, rounded up to the coarsest power of two number of ticks that fits in the tolerance so
+/// timers with overlapping windows share a slot and fire in the same wakeup.
+/// </summary>
+static uint64_t wheel_expiry_tick(DX_TIMER_BINDING *timer)
+{
+	uint64_t granularity = 1;
+	uint64_t expiry      = (timer->__wheel_expiry + DX_TIMER_WHEEL_TICK_MS - 1) / DX_TIMER_WHEEL_TICK_MS;
+
+	while (granularity * 2 * DX_TIMER_WHEEL_TICK_MS <= timer->tolerance_ms)
+	{
+		granularity *= 2;
+	}
+
+	return (expiry + granularity - 1) & ~(granularity - 1);
+}
+
+static void wheel_place(DX_TIMER_BINDING *timer)
+{
+	uint64_t expiry = wheel_expiry_tick(timer);
+	uint64_t delta;
+
+	// cascaded timers due now go in the current slot, which is expired next
+	if (expiry < wheel_now)
+	{
+		expiry = wheel_now;
+	}
+
+	delta = expiry - wheel_now;
+
+	if (delta < WHEEL_L0_SIZE)
+	{
+		wheel_list_add(&wheel_l0[expiry & (WHEEL_L0_SIZE - 1)], &timer->__wheel_node);
+		return;
+	}
+
+	// expiries beyond the top level are parked in its furthest slot and placed again when it cascades
+	if (delta > WHEEL_MAX_TICKS)
+	{
+		expiry = wheel_now + WHEEL_MAX_TICKS;
+	}
+
+	for (int level = 0; level < WHEEL_LEVELS - 1; level++)
+	{
+		int shift = WHEEL_L0_BITS + level * WHEEL_LN_BITS;
+
+		if (level == WHEEL_LEVELS - 2 || delta < (1ULL << (shift + WHEEL_LN_BITS)))
+		{
+			wheel_list_add(&wheel_ln[level][(expiry >> shift) & (WHEEL_LN_SIZE - 1)], &timer->__wheel_node);
+			return;
+		}
+	}
+}
+
+static void wheel_cascade(int level)
+{
+	int shift = WHEEL_L0_BITS + level * WHEEL_LN_BITS;
+	int index = (int)((wheel_now >> shift) & (WHEEL_LN_SIZE - 1));
+	DX_TIMER_WHEEL_NODE pending;
+
+	if (index == 0 && level < WHEEL_LEVELS - 2)
+	{
+		wheel_cascade(level + 1);
+	}
+
+	wheel_list_move(&wheel_ln[level][index], &pending);
+
+	while (pending.next != &pending)
+	{
+		DX_TIMER_WHEEL_NODE *node = pending.next;
+		wheel_list_remove(node);
+		wheel_place(container_of(node, DX_TIMER_BINDING, __wheel_node));
+	}
+}
+
+static void wheel_arm(void);
+
+static void wheel_expire_slot(void)
+{
+	DX_TIMER_WHEEL_NODE pending;
+
+	// handlers can start and stop timers, including ones still pending in this slot
+	wheel_list_move(&wheel_l0[wheel_now & (WHEEL_L0_SIZE - 1)], &pending);
+
+	while (pending.next != &pending)
+	{
+		DX_TIMER_WHEEL_NODE *node = pending.next;
+		DX_TIMER_BINDING *timer   = container_of(node, DX_TIMER_BINDING, __wheel_node);
+
+		wheel_list_remove(node);
+		wheel_count--;
+
+		if (timer->__wheel_period_ms)
+		{
+			// repeat from the scheduled expiry so periodic timers do not drift
+			timer->__wheel_expiry += timer->__wheel_period_ms;
+
+			// the slot being expired has already been moved to pending, a period shorter than a tick or a timer that
+			// fell behind would otherwise land in it and wait a full turn of the wheel
+			if (wheel_expiry_tick(timer) <= wheel_now)
+			{
+				timer->__wheel_expiry = (wheel_now + 1) * DX_TIMER_WHEEL_TICK_MS;
+			}
+
+			wheel_place(timer);
+			wheel_count++;
+		}
+
+		timer->handler(&timer->timer_handle);
+	}
+}
+
+static void wheel_driver_handler(uv_timer_t *handle)
+{
+	uint64_t target = uv_now(uv_default_loop()) / DX_TIMER_WHEEL_TICK_MS;
+
+	while (wheel_now < target && wheel_count > 0)
+	{
+		wheel_now++;
+
+		if ((wheel_now & (WHEEL_L0_SIZE - 1)) == 0)
+		{
+			wheel_cascade(0);
+		}
+
+		wheel_expire_slot();
+	}
+
+	if (wheel_count == 0)
+	{
+		wheel_now = target;
+	}
+
+	wheel_arm();
+}
+
+static void wheel_arm(void)
+{
+	uint64_t next;
+
+	if (wheel_count == 0)
+	{
+		uv_timer_stop(&wheel_driver);
+		return;
+	}
+
+	// next occupied level 0 slot before the next cascade, otherwise wake for the cascade
+	for (next = wheel_now + 1; (next & (WHEEL_L0_SIZE - 1)) != 0; next++)
+	{
+		if (wheel_l0[next & (WHEEL_L0_SIZE - 1)].next != &wheel_l0[next & (WHEEL_L0_SIZE - 1)])
+		{
+			break;
+		}
+	}
+
+	uint64_t now_ms = uv_now(uv_default_loop());
+	uint64_t due_ms = next * DX_TIMER_WHEEL_TICK_MS;
+
+	uv_timer_start(&wheel_driver, wheel_driver_handler, due_ms > now_ms ? due_ms - now_ms : 0, 0);
+}
+
+static void wheel_remove(DX_TIMER_BINDING *timer)
+{
+	if (timer->__wheel_node.next)
+	{
+		wheel_list_remove(&timer->__wheel_node);
+		wheel_count--;
+	}
+}
+
+static void wheel_schedule(DX_TIMER_BINDING *timer, uint64_t delay_ms, uint64_t period_ms)
+{
+	if (!wheel_initialized)
+	{
+		wheel_init();
+	}
+
+	wheel_remove(timer);
+
+	if (wheel_count == 0)
+	{
+		wheel_now = uv_now(uv_default_loop()) / DX_TIMER_WHEEL_TICK_MS;
+	}
+
+	timer->__wheel_expiry    = uv_now(uv_default_loop()) + delay_ms;
+	timer->__wheel_period_ms = period_ms;
+
+	// the current slot has already been expired
+	if (wheel_expiry_tick(timer) <= wheel_now)
+	{
+		timer->__wheel_expiry = (wheel_now + 1) * DX_TIMER_WHEEL_TICK_MS;
+	}
+
+	wheel_place(timer);
+	wheel_count++;
+	wheel_arm();
+}
+
 bool dx_timerChange(DX_TIMER_BINDING *timer, const struct timespec *repeat)
 {
 	if (!timer->initialized)
@@ -18,6 +294,14 @@ bool dx_timerChange(DX_TIMER_BINDING *timer, const struct timespec *repeat)
 
 	uint64_t timer_ms = repeat->tv_sec * 1000;
 	timer_ms          = timer_ms + repeat->tv_nsec / 1000000;
+
+	if (timer->tolerance_ms)
+	{
+		// like uv_timer_set_repeat the new period takes effect from the next expiry
+		timer->__wheel_period_ms = timer_ms;
+		return true;
+	}
+
 	uv_timer_set_repeat(&timer->timer_handle, timer_ms);
 
 	return true;
@@ -35,6 +319,22 @@ bool dx_timerStart(DX_TIMER_BINDING *timer)
 			return false;
 		}
 
+		if (timer->tolerance_ms)
+		{
+			if (timer->delay)
+			{
+				wheel_schedule(timer, timer->delay->tv_sec * 1000 + timer->delay->tv_nsec / 1000000, 0);
+			}
+			else if (timer->repeat)
+			{
+				uint64_t timer_ms = timer->repeat->tv_sec * 1000 + timer->repeat->tv_nsec / 1000000;
+				wheel_schedule(timer, timer_ms, timer_ms);
+			}
+
+			timer->initialized = true;
+			return true;
+		}
+
 		uv_timer_init(uv_default_loop(), &timer->timer_handle);
 
 		if (timer->delay)
@@ -71,7 +371,15 @@ void dx_timerStop(DX_TIMER_BINDING *timer)
 {
 	if (timer->initialized)
 	{
-		uv_timer_stop(&timer->timer_handle);
+		if (timer->tolerance_ms)
+		{
+			wheel_remove(timer);
+			wheel_arm();
+		}
+		else
+		{
+			uv_timer_stop(&timer->timer_handle);
+		}
 		timer->initialized = false;
 	}
 }
@@ -111,6 +419,13 @@ bool dx_timerOneShotSet(DX_TIMER_BINDING *timer, const struct timespec *period)
 		int64_t period_ms = period->tv_sec * 1000;
 		period_ms         = period_ms + period->tv_nsec / 1000000;
 
+		if (timer->tolerance_ms)
+		{
+			// the loop time is accurate enough for a timer with a tolerance, no need to update it
+			wheel_schedule(timer, (uint64_t)period_ms, 0);
+			return true;
+		}
+
 		uv_update_time(uv_default_loop());
 		uv_timer_start(&timer->timer_handle, timer->handler, period_ms, 0);
 
@@ -18,12 +18,28 @@
 #include <sys/types.h>
 #include <time.h>
 
-static char *_log_debug_buffer = NULL;
-static size_t _log_debug_buffer_size;
 static volatile bool network_timer_initialised = false;
 static bool network_connected_cached = false;
-
-static const char end_to_end_test_url[] = "http://www.msftconnecttest.com";
+static bool network_connected_state = false;
+static void (*network_reachability_changed)(bool connected) = NULL;
+
+// Non blocking end to end probe driven by the event loop, resolves the test host, connects and expects an HTTP response
+#define NETWORK_PROBE_TIMEOUT_MS 5000
+static const char network_probe_host[] = "www.msftconnecttest.com";
+static const char network_probe_request[] = "HEAD / HTTP/1.1\r\nHost: www.msftconnecttest.com\r\nConnection: close\r\n\r\n";
+
+static struct {
+    uv_getaddrinfo_t resolver;
+    uv_tcp_t socket;
+    uv_connect_t connect;
+    uv_write_t write;
+    uv_timer_t timeout;
+    char response[16];
+    bool active;
+    bool resolving;
+    bool socket_open;
+    bool timer_initialised;
+} network_probe;
 
 static DX_DECLARE_TIMER_HANDLER(network_connected_expired_handler);
 static DX_TIMER_BINDING tmr_network_connected_cached = {.name = "tmr_network_connected_cached", .handler = network_connected_expired_handler};
@@ -82,25 +98,66 @@ static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, voi
     return realsize;
 }
 
+// dx_getHttpData may be called from dx_work pool threads, each thread keeps its own easy handle and DNS results,
+// connections and TLS sessions are shared between them
+static pthread_once_t http_data_once = PTHREAD_ONCE_INIT;
+static CURLSH *http_data_share = NULL;
+static pthread_mutex_t http_data_share_locks[CURL_LOCK_DATA_LAST];
+static __thread CURL *curl_handle = NULL;
+
+static void http_data_share_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+    pthread_mutex_lock(&http_data_share_locks[data]);
+}
+
+static void http_data_share_unlock(CURL *handle, curl_lock_data data, void *userptr)
+{
+    pthread_mutex_unlock(&http_data_share_locks[data]);
+}
+
+static void http_data_init(void)
+{
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&http_data_share_locks[i], NULL);
+    }
+
+    if ((http_data_share = curl_share_init()) != NULL) {
+        curl_share_setopt(http_data_share, CURLSHOPT_LOCKFUNC, http_data_share_lock);
+        curl_share_setopt(http_data_share, CURLSHOPT_UNLOCKFUNC, http_data_share_unlock);
+        curl_share_setopt(http_data_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(http_data_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(http_data_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+}
+
 // https://curl.se/libcurl/c/getinmemory.html
+// Blocking, use dx_httpRequestAsync or run it with dx_work to avoid blocking the event loop
 char *dx_getHttpData(const char *url, long timeout)
 {
-    static bool curl_initialized = false;
-    CURL *curl_handle;
     CURLcode res;
 
-    if (!curl_initialized) {
-        curl_global_init(CURL_GLOBAL_ALL);
-        curl_initialized = true;
-    }
+    pthread_once(&http_data_once, http_data_init);
 
     struct MemoryStruct chunk;
 
     chunk.memory = malloc(1); /* will be grown as needed by the realloc above */
     chunk.size = 0;           /* no data at this point */
 
-    /* init the curl session */
-    curl_handle = curl_easy_init();
+    /* init the curl session for this thread, reset keeps live connections and the session cache */
+    if (curl_handle == NULL) {
+        if ((curl_handle = curl_easy_init()) == NULL) {
+            free(chunk.memory);
+            return NULL;
+        }
+    } else {
+        curl_easy_reset(curl_handle);
+    }
+
+    if (http_data_share != NULL) {
+        curl_easy_setopt(curl_handle, CURLOPT_SHARE, http_data_share);
+    }
 
     /* specify URL to get */
     curl_easy_setopt(curl_handle, CURLOPT_URL, url);
@@ -124,11 +181,11 @@ char *dx_getHttpData(const char *url, long timeout)
     // based on the libcurl sample - https://curl.se/libcurl/c/https.html
     curl_easy_setopt(curl_handle, CURLOPT_SSL_VERIFYPEER, 0L);
 
+    curl_easy_setopt(curl_handle, CURLOPT_TCP_KEEPALIVE, 1L);
+
     /* get it! */
     res = curl_easy_perform(curl_handle);
 
-    curl_easy_cleanup(curl_handle);
-
     if (res == CURLE_OK) {
         // caller is responsible for freeing this.
         return chunk.memory;
@@ -170,10 +227,132 @@ DX_TIMER_HANDLER(network_connected_expired_handler)
 }
 DX_TIMER_HANDLER_END
 
+static void network_probe_complete(bool connected);
+
+static void network_probe_socket_closed(uv_handle_t *handle)
+{
+    network_probe.socket_open = false;
+}
+
+static void network_probe_alloc(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
+{
+    *buf = uv_buf_init(network_probe.response, sizeof(network_probe.response));
+}
+
+static void network_probe_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
+{
+    if (nread > 0) {
+        // any HTTP response means the test host was reached end to end
+        network_probe_complete(nread >= 5 && memcmp(buf->base, "HTTP/", 5) == 0);
+    } else if (nread < 0) {
+        network_probe_complete(false);
+    }
+}
+
+static void network_probe_connected(uv_connect_t *req, int status)
+{
+    uv_buf_t request = uv_buf_init((char *)network_probe_request, sizeof(network_probe_request) - 1);
+
+    if (status < 0 || uv_write(&network_probe.write, (uv_stream_t *)&network_probe.socket, &request, 1, NULL) != 0 ||
+        uv_read_start((uv_stream_t *)&network_probe.socket, network_probe_alloc, network_probe_read) != 0) {
+        network_probe_complete(false);
+    }
+}
+
+static void network_probe_resolved(uv_getaddrinfo_t *req, int status, struct addrinfo *res)
+{
+    network_probe.resolving = false;
+
+    // the probe timed out while resolving
+    if (!network_probe.active) {
+        uv_freeaddrinfo(res);
+        return;
+    }
+
+    if (status < 0 || res == NULL) {
+        uv_freeaddrinfo(res);
+        network_probe_complete(false);
+        return;
+    }
+
+    uv_tcp_init(uv_default_loop(), &network_probe.socket);
+    network_probe.socket_open = true;
+
+    if (uv_tcp_connect(&network_probe.connect, &network_probe.socket, res->ai_addr, network_probe_connected) != 0) {
+        network_probe_complete(false);
+    }
+
+    uv_freeaddrinfo(res);
+}
+
+static void network_probe_timeout(uv_timer_t *handle)
+{
+    if (network_probe.resolving) {
+        uv_cancel((uv_req_t *)&network_probe.resolver);
+    }
+    network_probe_complete(false);
+}
+
+static void network_probe_complete(bool connected)
+{
+    if (!network_probe.active) {
+        return;
+    }
+
+    network_probe.active = false;
+    uv_timer_stop(&network_probe.timeout);
+
+    if (network_probe.socket_open && !uv_is_closing((uv_handle_t *)&network_probe.socket)) {
+        uv_close((uv_handle_t *)&network_probe.socket, network_probe_socket_closed);
+    }
+
+    if (connected) {
+        network_connected_cached = true;
+        // 3 minute cache on end to end testing
+        dx_timerOneShotSet(&tmr_network_connected_cached, &(struct timespec){3 * 60, 0});
+    }
+
+    if (connected != network_connected_state) {
+        network_connected_state = connected;
+
+        if (network_reachability_changed != NULL) {
+            network_reachability_changed(connected);
+        }
+    }
+}
+
+static void network_probe_start(void)
+{
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+
+    // previous probe still running or its handles not yet released
+    if (network_probe.active || network_probe.resolving || network_probe.socket_open) {
+        return;
+    }
+
+    if (!network_probe.timer_initialised) {
+        uv_timer_init(uv_default_loop(), &network_probe.timeout);
+        network_probe.timer_initialised = true;
+    }
+
+    network_probe.active = true;
+    uv_timer_start(&network_probe.timeout, network_probe_timeout, NETWORK_PROBE_TIMEOUT_MS, 0);
+
+    if (uv_getaddrinfo(uv_default_loop(), &network_probe.resolver, network_probe_resolved, network_probe_host, "80", &hints) == 0) {
+        network_probe.resolving = true;
+    } else {
+        network_probe_complete(false);
+    }
+}
+
+void dx_setNetworkReachabilityCallback(void (*reachabilityChanged)(bool connected))
+{
+    network_reachability_changed = reachabilityChanged;
+}
+
 bool dx_isNetworkConnected(const char *networkInterface)
 {
     bool network_ready = false;
-    char *network_connected_result = NULL;
 
     if (!network_timer_initialised)
     {
@@ -194,20 +373,10 @@ bool dx_isNetworkConnected(const char *networkInterface)
         return network_ready;
     }
 
-    network_connected_result = dx_getHttpData(end_to_end_test_url, 1);
+    // report the last probe result, the probe updates it and calls the reachability callback when it completes
+    network_probe_start();
 
-    if (network_connected_result == NULL) {
-        return false;
-    } else {
-        free(network_connected_result);
-        network_connected_result = NULL;
-
-        network_connected_cached = true;
-        // 3 minute cache on end to end testing
-        dx_timerOneShotSet(&tmr_network_connected_cached, &(struct timespec){3 * 60, 0});
-    }
-
-    return true;
+    return network_connected_state;
 }
 
 bool dx_isDeviceAuthReady(void)
@@ -278,29 +447,3 @@ bool dx_startThreadDetached(void *(*daemon)(void *), void *arg, char *daemon_nam
     }
     return true;
 }
-
-void dx_Log_Debug_Init(char *buffer, size_t buffer_size)
-{
-    _log_debug_buffer = (char *)buffer;
-    _log_debug_buffer_size = buffer_size;
-}
-
-void dx_Log_Debug(char *fmt, ...)
-{
-    if (_log_debug_buffer == NULL)
-    {
-        printf("log_debug_buffer is NULL. Call Log_Debug_Time_Init first");
-        return;
-    }
-
-    time_t t = time(NULL);
-    struct tm tm = *localtime(&t);
-    printf("%02d:%02d:%02d - ", tm.tm_hour, tm.tm_min, tm.tm_sec);
-
-    va_list args;
-    va_start(args, fmt);
-    vsnprintf(_log_debug_buffer, _log_debug_buffer_size, fmt, args);
-    va_end(args);
-
-    printf("%s", _log_debug_buffer);
-}
\ No newline at end of file
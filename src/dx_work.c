@@ -0,0 +1,156 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License. */
+
+#include "dx_work.h"
+#include <stddef.h>
+#include <stdio.h>
+
+// http://docs.libuv.org/en/v1.x/threadpool.html
+
+#define WORK_FROM_REQUEST(request) ((DX_WORK *)((char *)(request)-offsetof(DX_WORK, __request)))
+
+static bool work_start(DX_WORK *work);
+
+static void work_callback(uv_work_t *request)
+{
+	DX_WORK *work = WORK_FROM_REQUEST(request);
+	work->work(work);
+}
+
+static void after_work_callback(uv_work_t *request, int status)
+{
+	DX_WORK *work        = WORK_FROM_REQUEST(request);
+	DX_WORK_QUEUE *queue = work->queue;
+
+	work->__state = DX_WORK_IDLE;
+
+	// hand the slot to the next waiting item before the callback so a resubmit from after_work queues behind it
+	if (queue)
+	{
+		queue->__running--;
+
+		while (queue->__pending_head)
+		{
+			DX_WORK *next         = queue->__pending_head;
+			queue->__pending_head = next->__next;
+			if (!queue->__pending_head)
+			{
+				queue->__pending_tail = NULL;
+			}
+			next->__next = NULL;
+
+			if (work_start(next))
+			{
+				break;
+			}
+
+			// the item was accepted by dx_workSubmit, report it as cancelled and try the next one
+			if (next->after_work)
+			{
+				next->after_work(next, true);
+			}
+		}
+	}
+
+	if (work->after_work)
+	{
+		work->after_work(work, status == UV_ECANCELED);
+	}
+}
+
+static bool work_start(DX_WORK *work)
+{
+	int result;
+
+	if ((result = uv_queue_work(uv_default_loop(), &work->__request, work_callback, after_work_callback)) < 0)
+	{
+		printf("uv_queue_work failed for %s: %s\n", work->name ? work->name : "work", uv_strerror(result));
+		work->__state = DX_WORK_IDLE;
+		return false;
+	}
+
+	work->__state = DX_WORK_QUEUED;
+
+	if (work->queue)
+	{
+		work->queue->__running++;
+	}
+
+	return true;
+}
+
+bool dx_workSubmit(DX_WORK *work)
+{
+	if (!work || !work->work || work->__state != DX_WORK_IDLE)
+	{
+		return false;
+	}
+
+	work->__next = NULL;
+
+	if (work->queue && work->queue->max_concurrency && work->queue->__running >= work->queue->max_concurrency)
+	{
+		work->__state = DX_WORK_PENDING;
+
+		if (work->queue->__pending_tail)
+		{
+			work->queue->__pending_tail->__next = work;
+		}
+		else
+		{
+			work->queue->__pending_head = work;
+		}
+		work->queue->__pending_tail = work;
+
+		return true;
+	}
+
+	return work_start(work);
+}
+
+bool dx_workCancel(DX_WORK *work)
+{
+	if (!work)
+	{
+		return false;
+	}
+
+	if (work->__state == DX_WORK_PENDING)
+	{
+		DX_WORK *previous = NULL;
+
+		for (DX_WORK *item = work->queue->__pending_head; item; previous = item, item = item->__next)
+		{
+			if (item == work)
+			{
+				if (previous)
+				{
+					previous->__next = work->__next;
+				}
+				else
+				{
+					work->queue->__pending_head = work->__next;
+				}
+
+				if (work->queue->__pending_tail == work)
+				{
+					work->queue->__pending_tail = previous;
+				}
+				break;
+			}
+		}
+
+		work->__next  = NULL;
+		work->__state = DX_WORK_IDLE;
+
+		if (work->after_work)
+		{
+			work->after_work(work, true);
+		}
+
+		return true;
+	}
+
+	// only succeeds if a pool thread has not picked the work up, after_work_callback then runs with UV_ECANCELED
+	return work->__state == DX_WORK_QUEUED && uv_cancel((uv_req_t *)&work->__request) == 0;
+}